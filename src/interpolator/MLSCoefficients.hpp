@@ -26,26 +26,173 @@ void BasisPoly(ScratchVecView basis_monomial, Coord& p1) {
   basis_monomial(5) = p1.y * p1.y;
 }
 
-// radial basis function
-KOKKOS_INLINE_FUNCTION
-double rbf(double r_sq, double rho_sq) {
-  double phi;
-  double r = sqrt(r_sq);
-  double rho = sqrt(rho_sq);
-  double ratio = r / rho;
-  double limit = 1 - ratio;
-  if (limit < 0) {
-    phi = 0;
-
-  } else {
-    phi = 5 * pow(ratio, 5) + 30 * pow(ratio, 4) + 72 * pow(ratio, 3) +
-          82 * pow(ratio, 2) + 36 * ratio + 6;
-    phi = phi * pow(limit, 6);
+// quantities the MLS interpolation computes at each target
+enum class MLSDerivatives {
+  NONE,      // value
+  GRADIENT,  // value, d/dx, d/dy
+  HESSIAN    // value, d/dx, d/dy, d2/dx2, d2/dxdy, d2/dy2
+};
+
+inline int num_mls_components(MLSDerivatives derivatives) {
+  switch (derivatives) {
+    case MLSDerivatives::GRADIENT:
+      return 3;
+    case MLSDerivatives::HESSIAN:
+      return 6;
+    default:
+      return 1;
   }
+}
 
-  return phi;
+// polynomial basis vector and its derivatives, one row per component of
+// MLSDerivatives. Applying the MLS coefficients to the derivatives of the
+// basis gives the (diffuse) derivatives of the approximation
+KOKKOS_INLINE_FUNCTION
+void BasisPolyDerivatives(ScratchMatView basis_monomials, Coord& p1) {
+  int ncomponents = basis_monomials.extent(0);
+  ScratchVecView basis_monomial =
+      Kokkos::subview(basis_monomials, 0, Kokkos::ALL());
+  BasisPoly(basis_monomial, p1);
+  if (ncomponents > 1) {
+    // d/dx
+    basis_monomials(1, 0) = 0;
+    basis_monomials(1, 1) = 1;
+    basis_monomials(1, 2) = 0;
+    basis_monomials(1, 3) = 2 * p1.x;
+    basis_monomials(1, 4) = p1.y;
+    basis_monomials(1, 5) = 0;
+    // d/dy
+    basis_monomials(2, 0) = 0;
+    basis_monomials(2, 1) = 0;
+    basis_monomials(2, 2) = 1;
+    basis_monomials(2, 3) = 0;
+    basis_monomials(2, 4) = p1.x;
+    basis_monomials(2, 5) = 2 * p1.y;
+  }
+  if (ncomponents > 3) {
+    for (int k = 0; k < 6; ++k) {
+      basis_monomials(3, k) = 0;
+      basis_monomials(4, k) = 0;
+      basis_monomials(5, k) = 0;
+    }
+    basis_monomials(3, 3) = 2;  // d2/dx2
+    basis_monomials(4, 4) = 1;  // d2/dxdy
+    basis_monomials(5, 5) = 2;  // d2/dy2
+  }
 }
 
+// compactly supported radial basis functions
+// each kernel takes the squared distance and the squared cutoff radius and is
+// zero outside of the cutoff. Polynomial kernels are evaluated in Horner form
+// of the normalized distance so only a single sqrt is needed per support
+
+// (1-r)^6 (5r^5 + 30r^4 + 72r^3 + 82r^2 + 36r + 6) (Wu)
+struct RBFWu {
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    double ratio = sqrt(ratio_sq);
+    double limit = 1 - ratio;
+    double limit_sq = limit * limit;
+    double limit_6 = limit_sq * limit_sq * limit_sq;
+    double poly =
+        6 +
+        ratio * (36 + ratio * (82 + ratio * (72 + ratio * (30 + 5 * ratio))));
+    return poly * limit_6;
+  }
+};
+
+// (1-r)^2
+struct RBFWendlandC0 {
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    double limit = 1 - sqrt(ratio_sq);
+    return limit * limit;
+  }
+};
+
+// (1-r)^4 (4r + 1)
+struct RBFWendlandC2 {
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    double ratio = sqrt(ratio_sq);
+    double limit = 1 - ratio;
+    double limit_sq = limit * limit;
+    return limit_sq * limit_sq * (4 * ratio + 1);
+  }
+};
+
+// (1-r)^6 (35r^2 + 18r + 3)
+struct RBFWendlandC4 {
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    double ratio = sqrt(ratio_sq);
+    double limit = 1 - ratio;
+    double limit_sq = limit * limit;
+    return limit_sq * limit_sq * limit_sq * (3 + ratio * (18 + 35 * ratio));
+  }
+};
+
+// exp(-shape r^2) shifted to vanish at the cutoff
+// works on the squared distance directly so no sqrt is needed
+struct RBFGaussian {
+  double shape = 4.0;
+
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    return exp(-shape * ratio_sq) - exp(-shape);
+  }
+};
+
+// 1/sqrt(1 + shape r^2) shifted to vanish at the cutoff
+struct RBFInverseMultiquadric {
+  double shape = 4.0;
+
+  KOKKOS_INLINE_FUNCTION
+  double operator()(double r_sq, double rho_sq) const {
+    double ratio_sq = r_sq / rho_sq;
+    if (ratio_sq >= 1) {
+      return 0;
+    }
+    return 1 / sqrt(1 + shape * ratio_sq) - 1 / sqrt(1 + shape);
+  }
+};
+
+// runtime selector for the radial basis function. The selected kernel is
+// dispatched to a template instantiation so the kernel is inlined in the MLS
+// loop
+enum class RadialBasis {
+  WU,
+  WENDLAND_C0,
+  WENDLAND_C2,
+  WENDLAND_C4,
+  GAUSSIAN,
+  INVERSE_MULTIQUADRIC
+};
+
+// default radial basis function
+KOKKOS_INLINE_FUNCTION
+double rbf(double r_sq, double rho_sq) { return RBFWu{}(r_sq, rho_sq); }
+
 // create vandermondeMatrix
 KOKKOS_INLINE_FUNCTION
 void VandermondeMatrix(ScratchMatView V, ScratchMatView local_source_points,
@@ -72,15 +219,15 @@ void PTphiMatrix(ScratchMatView pt_phi, ScratchMatView V, ScratchVecView Phi,
 }
 
 // radial basis function vector
-KOKKOS_INLINE_FUNCTION
-void PhiVector(ScratchVecView Phi, Coord target_point,
-               ScratchMatView local_source_points, int j,
-               double cuttoff_dis_sq) {
-  int N = local_source_points.extent(0);
+template <typename Func>
+KOKKOS_INLINE_FUNCTION void PhiVector(ScratchVecView Phi, Coord target_point,
+                                      ScratchMatView local_source_points,
+                                      int j, double cuttoff_dis_sq,
+                                      const Func& rbf_func) {
   double dx = target_point.x - local_source_points(j, 0);
   double dy = target_point.y - local_source_points(j, 1);
   double ds_sq = dx * dx + dy * dy;
-  Phi(j) = rbf(ds_sq, cuttoff_dis_sq);
+  Phi(j) = rbf_func(ds_sq, cuttoff_dis_sq);
 }
 
 // matrix matrix multiplication
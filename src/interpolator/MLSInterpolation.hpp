@@ -2,186 +2,296 @@
 #define MLS_INTERPOLATION_HPP
 
 #include "MLSCoefficients.hpp"
-#include "adj_search_dega2.hpp"
 #include "adj_search.hpp"
 #include "points.hpp"
 
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
 using namespace Omega_h;
 using namespace pcms;
 
-Write<Real> mls_interpolation(const Reals source_values,
-                              const Reals source_coordinates,
-                              const Reals target_coordinates,
-                              const SupportResults& support, const LO& dim,
-                              Write<Real> radii2) {
-  const auto nvertices_source = source_coordinates.size() / dim;
-  const auto nvertices_target = target_coordinates.size() / dim;
+// targets are grouped into bins of power-of-two support count ranges starting
+// at this size so that each bin launches with scratch and team size fitted to
+// its own supports rather than to the largest support set of the whole mesh
+static constexpr int min_bin_supports = 16;
+
+// scratch needed by a single team for a target with nsupports supports and
+// ncomponents computed quantities (value and derivatives)
+inline size_t mls_scratch_size(int nsupports, int ncomponents = 1) {
+  size_t total_shared_size = 0;
+  total_shared_size += ScratchMatView::shmem_size(6, 6) * 4;
+  total_shared_size += ScratchMatView::shmem_size(6, nsupports) * 2;
+  total_shared_size += ScratchMatView::shmem_size(nsupports, 6);
+  total_shared_size += ScratchMatView::shmem_size(ncomponents, 6);
+  total_shared_size += ScratchMatView::shmem_size(ncomponents, nsupports);
+  total_shared_size += ScratchVecView::shmem_size(nsupports);
+  total_shared_size += ScratchMatView::shmem_size(nsupports, 2);
+  return total_shared_size;
+}
 
-  // Kokkos::RangePolicy<Kokkos::DefaultExecutionSpace> range_policy(1,
-  // nvertices_target);
-
-  Kokkos::View<size_t*> shmem_each_team(
-      "stores the size required for each team", nvertices_target);
-  // Write<int> shmem_each_team(nvertices_target, 0, "stores the size required
-  // for each team member");
-
-  Kokkos::parallel_for(
-      "calculate the size required for scratch for each team", nvertices_target,
-      KOKKOS_LAMBDA(const int i) {
-        int start_ptr = support.supports_ptr[i];
-        int end_ptr = support.supports_ptr[i + 1];
-        int nsupports = end_ptr - start_ptr;
-
-        size_t total_shared_size = 0;
-
-        total_shared_size += ScratchMatView::shmem_size(6, 6) * 4;
-        total_shared_size += ScratchMatView::shmem_size(6, nsupports) * 2;
-        total_shared_size += ScratchMatView::shmem_size(nsupports, 6);
-        total_shared_size += ScratchVecView::shmem_size(6);
-        total_shared_size += ScratchVecView::shmem_size(nsupports) * 3;
-        total_shared_size += ScratchMatView::shmem_size(nsupports, 2);
-        shmem_each_team(i) = total_shared_size;
-      });
+struct SupportBins {
+  // target ids in each bin
+  std::vector<Write<LO>> targets;
+  // upper bound of the number of supports of the targets in each bin
+  std::vector<LO> max_supports;
+};
+
+// sort the targets into bins by their number of supports
+inline SupportBins bin_by_support_count(const SupportResults& support,
+                                        LO nvertices_target) {
+  HostRead<LO> supports_ptr(support.supports_ptr);
+  std::vector<std::vector<LO>> bin_targets;
+  for (LO i = 0; i < nvertices_target; ++i) {
+    int nsupports = supports_ptr[i + 1] - supports_ptr[i];
+    size_t bin = 0;
+    for (int upper = min_bin_supports; nsupports > upper; upper *= 2) {
+      ++bin;
+    }
+    if (bin >= bin_targets.size()) {
+      bin_targets.resize(bin + 1);
+    }
+    bin_targets[bin].push_back(i);
+  }
+
+  SupportBins bins;
+  for (size_t bin = 0; bin < bin_targets.size(); ++bin) {
+    const auto& targets = bin_targets[bin];
+    if (targets.empty()) {
+      continue;
+    }
+    HostWrite<LO> targets_h(targets.size(), "targets in support count bin");
+    for (size_t j = 0; j < targets.size(); ++j) {
+      targets_h[j] = targets[j];
+    }
+    bins.targets.push_back(targets_h.write());
+    bins.max_supports.push_back(min_bin_supports << bin);
+  }
+  return bins;
+}
 
-  size_t shared_size;
-  Kokkos::parallel_reduce(
-      "find_max", nvertices_target,
-      KOKKOS_LAMBDA(const int i, size_t& max_val_temp) {
-        if (shmem_each_team(i) > max_val_temp) {
-          max_val_temp = shmem_each_team(i);
-        }
-      },
-      Kokkos::Max<size_t>(shared_size));
-  printf("shared size = %d \n", shared_size);
+// source_values may hold several fields defined on the same source points,
+// stored field by field (nfields x nsource). The MLS coefficients of each
+// target are computed once and applied to all fields. With derivatives, the
+// value is followed by the derivatives of MLSDerivatives for each field, so
+// the result is stored as (nfields x ncomponents x ntarget)
+template <typename Func>
+Write<Real> mls_interpolation(
+    const Reals source_values, const Reals source_coordinates,
+    const Reals target_coordinates, const SupportResults& support,
+    const LO& dim, Write<Real> radii2, Func rbf_func,
+    MLSDerivatives derivatives = MLSDerivatives::NONE) {
+  const auto nvertices_source = source_coordinates.size() / dim;
+  const auto nvertices_target = target_coordinates.size() / dim;
+  OMEGA_H_CHECK(source_values.size() % nvertices_source == 0);
+  const auto nfields = source_values.size() / nvertices_source;
+  const int ncomponents = num_mls_components(derivatives);
+  const auto noutputs = nfields * ncomponents;
 
-  Write<Real> approx_target_values(nvertices_target, 0,
+  Write<Real> approx_target_values(noutputs * nvertices_target, 0,
                                    "approximated target values");
 
-  team_policy tp(nvertices_target, Kokkos::AUTO);
-
-  int scratch_size = tp.scratch_size_max(0);
-  printf("scratch size is %d \n", scratch_size);
+  const auto bins = bin_by_support_count(support, nvertices_target);
 
-  Kokkos::parallel_for(
-      "MLS coefficients", tp.set_scratch_size(0, Kokkos::PerTeam(shared_size)),
-      KOKKOS_LAMBDA(const member_type& team) {
-        int i = team.league_rank();
-        int start_ptr = support.supports_ptr[i];
-        int end_ptr = support.supports_ptr[i + 1];
+  for (size_t bin = 0; bin < bins.targets.size(); ++bin) {
+    const auto bin_targets = bins.targets[bin];
+    const int max_supports = bins.max_supports[bin];
+    const size_t shared_size = mls_scratch_size(max_supports, ncomponents);
+    // large support sets that do not fit in the fast scratch are moved to the
+    // (slower but larger) level 1 scratch
+    const int scratch_level =
+        static_cast<int>(shared_size) <=
+                team_policy(1, Kokkos::AUTO).scratch_size_max(0)
+            ? 0
+            : 1;
 
-        int nsupports = end_ptr - start_ptr;
+    auto mls_kernel = KOKKOS_LAMBDA(const member_type& team) {
+      int i = bin_targets[team.league_rank()];
+      int start_ptr = support.supports_ptr[i];
+      int end_ptr = support.supports_ptr[i + 1];
 
-        ScratchMatView local_source_points(team.team_scratch(0), nsupports, 2);
-        int count = -1;
-        for (int j = start_ptr; j < end_ptr; ++j) {
-          count++;
-          auto index = support.supports_idx[j];
-          local_source_points(count, 0) = source_coordinates[index * dim];
-          local_source_points(count, 1) = source_coordinates[index * dim + 1];
-        }
+      int nsupports = end_ptr - start_ptr;
 
-        ScratchMatView lower(team.team_scratch(0), 6, 6);
+      ScratchMatView local_source_points(team.team_scratch(scratch_level),
+                                         nsupports, 2);
+      int count = -1;
+      for (int j = start_ptr; j < end_ptr; ++j) {
+        count++;
+        auto index = support.supports_idx[j];
+        local_source_points(count, 0) = source_coordinates[index * dim];
+        local_source_points(count, 1) = source_coordinates[index * dim + 1];
+      }
 
-        ScratchMatView forward_matrix(team.team_scratch(0), 6, 6);
+      ScratchMatView lower(team.team_scratch(scratch_level), 6, 6);
 
-        ScratchMatView moment_matrix(team.team_scratch(0), 6, 6);
+      ScratchMatView forward_matrix(team.team_scratch(scratch_level), 6, 6);
 
-        ScratchMatView inv_mat(team.team_scratch(0), 6, 6);
+      ScratchMatView moment_matrix(team.team_scratch(scratch_level), 6, 6);
 
-        ScratchMatView V(team.team_scratch(0), nsupports, 6);
+      ScratchMatView inv_mat(team.team_scratch(scratch_level), 6, 6);
 
-        ScratchMatView Ptphi(team.team_scratch(0), 6, nsupports);
+      ScratchMatView V(team.team_scratch(scratch_level), nsupports, 6);
 
-        ScratchMatView resultant_matrix(team.team_scratch(0), 6, nsupports);
+      ScratchMatView Ptphi(team.team_scratch(scratch_level), 6, nsupports);
 
-        ScratchVecView targetMonomialVec(team.team_scratch(0), 6);
+      ScratchMatView resultant_matrix(team.team_scratch(scratch_level), 6,
+                                      nsupports);
 
-        ScratchVecView SupportValues(team.team_scratch(0), nsupports);
+      ScratchMatView targetMonomials(team.team_scratch(scratch_level),
+                                     ncomponents, 6);
 
-        ScratchVecView result(team.team_scratch(0), nsupports);
+      ScratchMatView result(team.team_scratch(scratch_level), ncomponents,
+                            nsupports);
 
-        ScratchVecView Phi(team.team_scratch(0), nsupports);
+      ScratchVecView Phi(team.team_scratch(scratch_level), nsupports);
 
-        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, 6), [=](int j) {
-          for (int k = 0; k < 6; ++k) {
-            lower(j, k) = 0;
-            forward_matrix(j, k) = 0;
-            moment_matrix(j, k) = 0;
-            inv_mat(j, k) = 0;
-          }
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(team, 6), [=](int j) {
+        for (int k = 0; k < 6; ++k) {
+          lower(j, k) = 0;
+          forward_matrix(j, k) = 0;
+          moment_matrix(j, k) = 0;
+          inv_mat(j, k) = 0;
+        }
 
-          targetMonomialVec(j) = 0;
-          for (int k = 0; k < nsupports; ++k) {
-            resultant_matrix(j, k) = 0;
+        for (int k = 0; k < nsupports; ++k) {
+          resultant_matrix(j, k) = 0;
 
-            Ptphi(j, k) = 0;
-          }
-        });
+          Ptphi(j, k) = 0;
+        }
+      });
 
-        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nsupports),
-                             [=](int j) {
-                               for (int k = 0; k < 6; ++k) {
-                                 V(j, k) = 0;
-                               }
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nsupports),
+                           [=](int j) {
+                             for (int k = 0; k < 6; ++k) {
+                               V(j, k) = 0;
+                             }
 
-                               SupportValues(j) = 0;
-                               result(j) = 0;
-                               Phi(j) = 0;
-                             });
+                             for (int c = 0; c < ncomponents; ++c) {
+                               result(c, j) = 0;
+                             }
+                             Phi(j) = 0;
+                           });
 
-        Coord target_point;
+      team.team_barrier();
 
-        target_point.x = target_coordinates[i * dim];
+      Coord target_point;
 
-        target_point.y = target_coordinates[i * dim + 1];
+      target_point.x = target_coordinates[i * dim];
 
-        BasisPoly(targetMonomialVec, target_point);
+      target_point.y = target_coordinates[i * dim + 1];
 
-        Kokkos::parallel_for(
-            Kokkos::TeamThreadRange(team, nsupports),
-            [=](int j) { VandermondeMatrix(V, local_source_points, j); });
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        BasisPolyDerivatives(targetMonomials, target_point);
+      });
 
-        team.team_barrier();
+      Kokkos::parallel_for(
+          Kokkos::TeamThreadRange(team, nsupports),
+          [=](int j) { VandermondeMatrix(V, local_source_points, j); });
 
-        Kokkos::parallel_for(
-            Kokkos::TeamThreadRange(team, nsupports), [=](int j) {
-              PhiVector(Phi, target_point, local_source_points, j, radii2[i]);
-            });
+      team.team_barrier();
 
-        team.team_barrier();
+      Kokkos::parallel_for(
+          Kokkos::TeamThreadRange(team, nsupports), [=](int j) {
+            PhiVector(Phi, target_point, local_source_points, j, radii2[i],
+                      rbf_func);
+          });
 
-        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nsupports),
-                             [=](int j) { PTphiMatrix(Ptphi, V, Phi, j); });
+      team.team_barrier();
 
-        team.team_barrier();
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nsupports),
+                           [=](int j) { PTphiMatrix(Ptphi, V, Phi, j); });
 
-        MatMatMul(team, moment_matrix, Ptphi, V);
-        team.team_barrier();
+      team.team_barrier();
 
-        inverse_matrix(team, moment_matrix, lower, forward_matrix, inv_mat);
+      MatMatMul(team, moment_matrix, Ptphi, V);
+      team.team_barrier();
 
-        team.team_barrier();
+      inverse_matrix(team, moment_matrix, lower, forward_matrix, inv_mat);
 
-        MatMatMul(team, resultant_matrix, inv_mat, Ptphi);
-        team.team_barrier();
+      team.team_barrier();
 
-        MatVecMul(team, targetMonomialVec, resultant_matrix, result);
-        team.team_barrier();
+      MatMatMul(team, resultant_matrix, inv_mat, Ptphi);
+      team.team_barrier();
 
-        Kokkos::parallel_for(
-            Kokkos::TeamThreadRange(team, nsupports), [=](const int i) {
-              SupportValues(i) =
-                  source_values[support.supports_idx[start_ptr + i]];
-            });
+      // one row of coefficients per component: the value and the
+      // derivatives of the approximation at the target
+      MatMatMul(team, result, targetMonomials, resultant_matrix);
+      team.team_barrier();
 
+      // the coefficients only depend on the source and target points so
+      // they are shared by every field
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(team, noutputs), [=](int o) {
+        const auto f = o / ncomponents;
+        const auto c = o % ncomponents;
+        const auto field_offset = f * nvertices_source;
         double tgt_value = 0;
-        dot_product(team, result, SupportValues, tgt_value);
-        if (team.team_rank() == 0) {
-          approx_target_values[i] = tgt_value;
-        }
+        Kokkos::parallel_reduce(
+            Kokkos::ThreadVectorRange(team, nsupports),
+            [=](const int j, double& lsum) {
+              lsum += result(c, j) *
+                      source_values[field_offset +
+                                    support.supports_idx[start_ptr + j]];
+            },
+            tgt_value);
+        Kokkos::single(Kokkos::PerThread(team), [=]() {
+          approx_target_values[o * nvertices_target + i] = tgt_value;
+        });
       });
+    };
+
+    const int nbin_targets = bin_targets.size();
+    team_policy probe_policy(nbin_targets, Kokkos::AUTO);
+    probe_policy.set_scratch_size(scratch_level,
+                                  Kokkos::PerTeam(shared_size));
+    // one thread per support is enough, larger teams only idle
+    const int team_size =
+        std::min(max_supports, probe_policy.team_size_recommended(
+                                   mls_kernel, Kokkos::ParallelForTag()));
+
+    team_policy tp(nbin_targets, team_size);
+    Kokkos::parallel_for(
+        "MLS coefficients",
+        tp.set_scratch_size(scratch_level, Kokkos::PerTeam(shared_size)),
+        mls_kernel);
+  }
 
   return approx_target_values;
 }
 
+inline Write<Real> mls_interpolation(
+    const Reals source_values, const Reals source_coordinates,
+    const Reals target_coordinates, const SupportResults& support,
+    const LO& dim, Write<Real> radii2, RadialBasis basis = RadialBasis::WU,
+    MLSDerivatives derivatives = MLSDerivatives::NONE) {
+  switch (basis) {
+    case RadialBasis::WU:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFWu{}, derivatives);
+    case RadialBasis::WENDLAND_C0:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFWendlandC0{}, derivatives);
+    case RadialBasis::WENDLAND_C2:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFWendlandC2{}, derivatives);
+    case RadialBasis::WENDLAND_C4:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFWendlandC4{}, derivatives);
+    case RadialBasis::GAUSSIAN:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFGaussian{}, derivatives);
+    case RadialBasis::INVERSE_MULTIQUADRIC:
+      return mls_interpolation(source_values, source_coordinates,
+                               target_coordinates, support, dim, radii2,
+                               RBFInverseMultiquadric{}, derivatives);
+  }
+  std::cerr << "unknown radial basis function\n";
+  std::abort();
+}
+
 #endif
@@ -1,8 +1,17 @@
 #ifndef ADJ_SEARCH_HPP
 #define ADJ_SEARCH_HPP
 
+#include <Omega_h_array_ops.hpp>
+#include <Omega_h_macros.h>
+#include <Omega_h_map.hpp>
+#include <Omega_h_scan.hpp>
+#include <Omega_h_shape.hpp>
 #include <pcms/point_search.h>
 
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
 #include "queue_visited.hpp"
 
 using namespace Omega_h;
@@ -24,39 +33,113 @@ Real calculateDistance(const Real* p1, const Real* p2, const int dim) {
   return dx * dx + dy * dy + dz * dz;
 }
 
-class FindSupports {
- private:
-  Mesh& source_mesh;
-  Mesh& target_mesh;
-
- public:
-  FindSupports(Mesh& source_mesh_, Mesh& target_mesh_)
-      : source_mesh(source_mesh_), target_mesh(target_mesh_) {};
+// largest candidate buffer the single pass support search allocates. Larger
+// searches count the supports first and fill exactly sized slots
+static constexpr double max_slot_candidates = 1 << 26;
+
+// squared radius beyond which a larger support radius can not find more
+// supports: the diagonal of the bounding box of the sources and targets, or
+// the largest radius whose BFS fits the largest visited set
+inline Real max_support_radius_sq(const Reals& source_coords,
+                                  const Reals& target_coords, LO dim,
+                                  Real area_per_source) {
+  Real diagonal_sq = 0;
+  for (LO d = 0; d < dim; ++d) {
+    const auto sources = get_component(source_coords, dim, d);
+    Real min = get_min(sources);
+    Real max = get_max(sources);
+    if (target_coords.size() > 0) {
+      const auto targets = get_component(target_coords, dim, d);
+      min = std::min(min, get_min(targets));
+      max = std::max(max, get_max(targets));
+    }
+    diagonal_sq += (max - min) * (max - min);
+  }
+  return std::min(diagonal_sq,
+                  max_bfs_radius_sq(bfs_capacity_large, area_per_source));
+}
 
-  void adjBasedSearch(const Real& cutoffDistance, const Write<LO>& supports_ptr,
-                      Write<LO>& nSupports, Write<LO>& support_idx);
+// the source entities whose values are interpolated
+enum class SupportSource {
+  VERTEX,         // vertices of the source mesh
+  CELL_CENTROID,  // centroids of the cells of the source mesh
 };
 
-void FindSupports::adjBasedSearch(const Real& cutoffDistance,
-                                  const Write<LO>& supports_ptr,
-                                  Write<LO>& nSupports,
-                                  Write<LO>& support_idx) {
-  //  Source Mesh Info
+namespace detail {
+// the kernels of the FindSupports constructors live in free functions, since
+// device lambdas can not be defined in constructors or private members
 
-  const auto& sourcePoints_coords = source_mesh.coords();
-  const auto nvertices_source = source_mesh.nverts();
-  const auto dim = source_mesh.dim();
+// coordinates of the centroids of the cells of a triangle mesh
+inline Reals cell_centroids(Mesh& mesh) {
+  const auto& mesh_coords = mesh.coords();
+  const auto nfaces = mesh.nfaces();
+  const auto& faces2nodes = mesh.ask_down(FACE, VERT).ab2b;
+  const auto dim = mesh.dim();
 
-  // Target Mesh Info
-  const auto& targetPoints_coords = target_mesh.coords();
-  const auto nvertices_target = target_mesh.nverts();
+  Write<Real> cell_centroids(
+      dim * nfaces, 0,
+      "stores coordinates of cell centroid of each tri element");
 
-  // CSR data structure of adjacent vertex information of each source vertex
-  const auto& vert2vert = source_mesh.ask_star(VERT);
-  const auto& v2v_ptr = vert2vert.a2ab;
-  const auto& v2v_data = vert2vert.ab2b;
+  parallel_for(
+      "calculate the centroid in each tri element", nfaces,
+      OMEGA_H_LAMBDA(const LO id) {
+        const auto current_el_verts = gather_verts<3>(faces2nodes, id);
+        const Omega_h::Few<Omega_h::Vector<2>, 3> current_el_vert_coords =
+            gather_vectors<3, 2>(mesh_coords, current_el_verts);
+        auto centroid = average(current_el_vert_coords);
+        int index = dim * id;
+        cell_centroids[index] = centroid[0];
+        cell_centroids[index + 1] = centroid[1];
+      });
+  return cell_centroids;
+}
+
+// CSR data structure of the neighbors of each cell of a triangle mesh. The
+// neighbors of a cell are the cells adjacent to its vertices. A cell may be
+// listed more than once, the visited set of the BFS filters them
+inline void cell_neighbors(Mesh& mesh, LOs& adj_ptr, LOs& adj_data) {
+  const auto nfaces = mesh.nfaces();
+  const auto& nodes2faces = mesh.ask_up(VERT, FACE);
+  const auto& n2f_ptr = nodes2faces.a2ab;
+  const auto& n2f_data = nodes2faces.ab2b;
+  const auto& faces2nodes = mesh.ask_down(FACE, VERT).ab2b;
+
+  Write<LO> nneighbors(nfaces, "number of neighbors of each cell");
+  parallel_for(
+      nfaces, OMEGA_H_LAMBDA(const LO id) {
+        LO count = 0;
+        for (LO i = id * 3; i < (id + 1) * 3; ++i) {
+          const LO vert = faces2nodes[i];
+          count += n2f_ptr[vert + 1] - n2f_ptr[vert];
+        }
+        nneighbors[id] = count;
+      });
+  adj_ptr = offset_scan(LOs(nneighbors));
+  const auto cell_adj_ptr = adj_ptr;
+  Write<LO> cell_adj_data(adj_ptr.last(), "neighbors of each cell");
+  parallel_for(
+      nfaces, OMEGA_H_LAMBDA(const LO id) {
+        LO position = cell_adj_ptr[id];
+        for (LO i = id * 3; i < (id + 1) * 3; ++i) {
+          const LO vert = faces2nodes[i];
+          for (LO j = n2f_ptr[vert]; j < n2f_ptr[vert + 1]; ++j) {
+            cell_adj_data[position++] = n2f_data[j];
+          }
+        }
+      });
+  adj_data = cell_adj_data;
+}
 
-  // CSR data structure of vertex information of each cell in source mesh
+// CSR data structure of the source entities the BFS of each target point
+// starts from: the source cell that holds the target or the vertices of that
+// cell. A target outside of the source mesh has no seeds and therefore no
+// supports
+inline void located_seeds(Mesh& source_mesh, const Reals& target_coords,
+                          const pcms::GridPointSearch& point_search,
+                          SupportSource source, LOs& seed_ptr,
+                          LOs& seed_data) {
+  const auto dim = source_mesh.dim();
+  const auto nvertices_target = target_coords.size() / dim;
 
   // CSR data structure of adjacent vertex information of each source vertex
   // dim == 2; ask vertices of tri (3 vertices for each tri) & if dim ==3; ask
@@ -67,152 +150,448 @@ void FindSupports::adjBasedSearch(const Real& cutoffDistance,
 
   parallel_for(
       nvertices_target, OMEGA_H_LAMBDA(const LO i) {
-        target_points(i, 0) = targetPoints_coords[i * dim];
-        target_points(i, 1) = targetPoints_coords[i * dim + 1];
+        target_points(i, 0) = target_coords[i * dim];
+        target_points(i, 1) = target_coords[i * dim + 1];
       });
   Kokkos::fence();
-  pcms::GridPointSearch search_cell(source_mesh, 10, 10);
 
   // get the cell id for each target point
-  auto results = search_cell(target_points);
+  auto results = point_search(target_points);
 
+  const LO nseeds = source == SupportSource::VERTEX ? dim + 1 : 1;
+  Write<LO> target_nseeds(nvertices_target, "number of seeds of each target");
   parallel_for(
-      nvertices_target,
-      OMEGA_H_LAMBDA(const LO id) {
-        queue queue;
-        track visited;
+      nvertices_target, OMEGA_H_LAMBDA(const LO id) {
+        target_nseeds[id] = results(id).tri_id < 0 ? 0 : nseeds;
+      });
+  seed_ptr = offset_scan(LOs(target_nseeds));
+  const auto target_seed_ptr = seed_ptr;
+  Write<LO> target_seeds(seed_ptr.last(), "seeds of each target");
+  parallel_for(
+      nvertices_target, OMEGA_H_LAMBDA(const LO id) {
+        const LO source_cell_id = results(id).tri_id;
+        if (source_cell_id < 0) {
+          return;
+        }
+        const LO start = target_seed_ptr[id];
+        if (nseeds == 1) {
+          target_seeds[start] = source_cell_id;
+          return;
+        }
+        for (LO i = 0; i < nseeds; ++i) {
+          target_seeds[start + i] = cells2verts[source_cell_id * nseeds + i];
+        }
+      });
+  seed_data = target_seeds;
+}
+}  // namespace detail
 
-        LO source_cell_id = results(id).tri_id;
+// adjacency based search of the supports of the vertices of the target mesh.
+// The BFS over the source entities starts from the source cell that holds
+// the target vertex, so the source and the target mesh may differ
+class FindSupports {
+ private:
+  LO dim;
+  Reals source_coords;  // coordinates of the source entities
+  Reals target_coords;  // coordinates of the target vertices
+  Real area_per_source;
+  Real max_radius2;  // squared radius at which the supports stop growing
 
-        const LO num_verts_in_dim = dim + 1;
+  // CSR data structure of the neighbors of each source entity
+  LOs adj_ptr;
+  LOs adj_data;
 
-        LO start_ptr = source_cell_id * num_verts_in_dim;
+  // CSR data structure of the source entities the BFS of each target vertex
+  // starts from
+  LOs seed_ptr;
+  LOs seed_data;
 
-        LO end_ptr = start_ptr + num_verts_in_dim;
+  void setSources(Mesh& source_mesh, SupportSource source);
 
-        Real target_coords[max_dim];
+  // runs the search with the smallest BFS capacity that fits the required
+  // capacity and returns true if even the largest capacity overflowed
+  bool adjBasedSearch(int required_capacity, const LOs& targets,
+                      const Write<Real>& radii2, Write<LO>& nSupports,
+                      const LOs& slot_ptr, const Write<LO>& candidates);
 
-        Real support_coords[max_dim];
+ public:
+  // targets are the vertices of the source mesh
+  FindSupports(Mesh& mesh, SupportSource source = SupportSource::CELL_CENTROID);
+
+  // targets are the vertices of the target mesh. The point search over the
+  // source mesh locates the source cell of each target vertex, so a cached
+  // one can be reused across searches
+  FindSupports(Mesh& source_mesh, Mesh& target_mesh,
+               const pcms::GridPointSearch& point_search,
+               SupportSource source = SupportSource::VERTEX);
+
+  FindSupports(Mesh& source_mesh, Mesh& target_mesh,
+               SupportSource source = SupportSource::VERTEX)
+      : FindSupports(source_mesh, target_mesh,
+                     pcms::GridPointSearch(source_mesh, 10, 10), source) {}
+
+  LO ntargets() const { return target_coords.size() / dim; }
+
+  // offsets of the seeds of each target vertex. A target vertex without seeds
+  // is outside of the source mesh and has no supports
+  const LOs& seedOffsets() const { return seed_ptr; }
+
+  // squared radius at which growing the support radius finds no more supports
+  Real maxRadius2() const { return max_radius2; }
+
+  // finds the supports of the listed target vertices. The supports of target
+  // vertex targets[k] are written to
+  // candidates[candidates_ptr[k], candidates_ptr[k + 1])
+  void adjBasedSearch(const LOs& targets, const Write<Real>& radii2,
+                      Write<LO>& candidates_ptr, Write<LO>& candidates);
+
+  // writes the supports of target vertex targets[k] to its slot
+  // candidates[slot_ptr[k], slot_ptr[k + 1]) and counts them in nSupports[k],
+  // also those that do not fit the slot. Returns true if the BFS of any target
+  // vertex overflowed the capacity
+  template <int Capacity>
+  bool adjBasedSearch(const LOs& targets, const Write<Real>& radii2,
+                      Write<LO>& nSupports, const LOs& slot_ptr,
+                      const Write<LO>& candidates);
+};
 
-        for (LO k = 0; k < dim; ++k) {
-          target_coords[k] = target_points(id, k);
-        }
+inline void FindSupports::setSources(Mesh& source_mesh,
+                                     SupportSource source) {
+  dim = source_mesh.dim();
+  const auto total_area = get_sum(measure_elements_real(&source_mesh));
 
-        LO start_counter;
+  if (source == SupportSource::VERTEX) {
+    source_coords = source_mesh.coords();
+    area_per_source = total_area / source_mesh.nverts();
 
-        if (support_idx.size() > 0) {
-          start_counter = supports_ptr[id];
-        }
+    // CSR data structure of adjacent vertex information of each source vertex
+    const auto& vert2vert = source_mesh.ask_star(VERT);
+    adj_ptr = vert2vert.a2ab;
+    adj_data = vert2vert.ab2b;
+    return;
+  }
 
-        int count = 0;
-        // Initialize queue by pushing the vertices in the neighborhood of the
-        // given target point
+  area_per_source = total_area / source_mesh.nfaces();
+  source_coords = ::detail::cell_centroids(source_mesh);
+  ::detail::cell_neighbors(source_mesh, adj_ptr, adj_data);
+}
 
-        for (LO i = start_ptr; i < end_ptr; ++i) {
-          LO vert_id = cells2verts[i];
-          visited.push_back(vert_id);
+inline FindSupports::FindSupports(Mesh& mesh, SupportSource source) {
+  setSources(mesh, source);
+  target_coords = mesh.coords();
+  max_radius2 = max_support_radius_sq(source_coords, target_coords, dim,
+                                      area_per_source);
+
+  // the BFS of a vertex starts from the vertex itself or from its adjacent
+  // cells
+  if (source == SupportSource::VERTEX) {
+    const auto nverts = mesh.nverts();
+    seed_ptr = LOs(nverts + 1, 0, 1, "seed offsets");
+    seed_data = LOs(nverts, 0, 1, "seed vertices");
+  } else {
+    const auto& nodes2faces = mesh.ask_up(VERT, FACE);
+    seed_ptr = nodes2faces.a2ab;
+    seed_data = nodes2faces.ab2b;
+  }
+}
+
+inline FindSupports::FindSupports(Mesh& source_mesh, Mesh& target_mesh,
+                                  const pcms::GridPointSearch& point_search,
+                                  SupportSource source) {
+  setSources(source_mesh, source);
+  target_coords = target_mesh.coords();
+  max_radius2 = max_support_radius_sq(source_coords, target_coords, dim,
+                                      area_per_source);
+  ::detail::located_seeds(source_mesh, target_coords, point_search, source,
+                        seed_ptr, seed_data);
+}
 
-          for (LO k = 0; k < dim; ++k) {
-            support_coords[k] = sourcePoints_coords[vert_id * dim + k];
+inline void FindSupports::adjBasedSearch(const LOs& targets,
+                                         const Write<Real>& radii2,
+                                         Write<LO>& candidates_ptr,
+                                         Write<LO>& candidates) {
+  const auto ntargets = targets.size();
+  if (ntargets == 0) {
+    candidates_ptr = Write<LO>(1, 0, "support candidate offsets");
+    candidates = Write<LO>(0, "support candidates");
+    return;
+  }
+  const auto max_radius2 = get_max(unmap(targets, Reals(radii2), 1));
+  const auto required_capacity =
+      estimate_bfs_capacity(max_radius2, area_per_source);
+
+  // the single pass writes the supports into equal slots sized for the
+  // expected support count. If those would take too much memory the pass
+  // only counts the supports
+  LO slot_size = estimate_support_count(max_radius2, area_per_source);
+  if (static_cast<double>(ntargets) * slot_size > max_slot_candidates) {
+    slot_size = 0;
+  }
+  Write<LO> nSupports(ntargets, "number of supports of each listed target");
+  Write<LO> slots(ntargets * slot_size, "support candidates");
+  bool overflow =
+      adjBasedSearch(required_capacity, targets, radii2, nSupports,
+                     LOs(ntargets + 1, 0, slot_size), slots);
+
+  const auto offsets = offset_scan(LOs(nSupports));
+  candidates_ptr = deep_copy(offsets);
+  if (!overflow && get_max(LOs(nSupports)) > slot_size) {
+    // the slots were too small for some targets, so redo the search with
+    // slots of the exact support counts
+    candidates = Write<LO>(offsets.last(), "support candidates");
+    overflow = adjBasedSearch(required_capacity, targets, radii2, nSupports,
+                              offsets, candidates);
+  } else if (!overflow) {
+    // compact the equal slots into the exact ones
+    candidates = Write<LO>(offsets.last(), "support candidates");
+    const auto compacted = candidates;
+    parallel_for(
+        ntargets, OMEGA_H_LAMBDA(const LO k) {
+          for (LO j = offsets[k]; j < offsets[k + 1]; ++j) {
+            compacted[j] = slots[k * slot_size + j - offsets[k]];
           }
+        });
+  }
+  if (overflow) {
+    std::cerr << "support search visited more than " << bfs_capacity_large / 2
+              << " sources for a target vertex. Reduce the cutoff radius.\n";
+    std::abort();
+  }
+}
+
+inline bool FindSupports::adjBasedSearch(int required_capacity,
+                                         const LOs& targets,
+                                         const Write<Real>& radii2,
+                                         Write<LO>& nSupports,
+                                         const LOs& slot_ptr,
+                                         const Write<LO>& candidates) {
+  bool overflow = true;
+  if (overflow && required_capacity <= bfs_capacity_small) {
+    overflow = adjBasedSearch<bfs_capacity_small>(targets, radii2, nSupports,
+                                                  slot_ptr, candidates);
+  }
+  if (overflow && required_capacity <= bfs_capacity_medium) {
+    overflow = adjBasedSearch<bfs_capacity_medium>(targets, radii2, nSupports,
+                                                   slot_ptr, candidates);
+  }
+  if (overflow) {
+    overflow = adjBasedSearch<bfs_capacity_large>(targets, radii2, nSupports,
+                                                  slot_ptr, candidates);
+  }
+  return overflow;
+}
+
+template <int Capacity>
+bool FindSupports::adjBasedSearch(const LOs& targets,
+                                  const Write<Real>& radii2,
+                                  Write<LO>& nSupports, const LOs& slot_ptr,
+                                  const Write<LO>& candidates) {
+  const auto ntargets = targets.size();
+  const auto dim = this->dim;
+  const auto source_coords = this->source_coords;
+  const auto target_coords = this->target_coords;
+  const auto adj_ptr = this->adj_ptr;
+  const auto adj_data = this->adj_data;
+  const auto seed_ptr = this->seed_ptr;
+  const auto seed_data = this->seed_data;
+
+  Write<LO> overflowed(ntargets, 0, "BFS capacity overflow of each target");
+
+  parallel_for(
+      ntargets,  // for each listed target vertex
+      OMEGA_H_LAMBDA(const LO k) {
+        const LO id = targets[k];
+        queue<Capacity / 2> queue;
+        track<Capacity> visited;
+        Real current_target_coords[max_dim];
+        Real support_coords[max_dim];
+        Real cutoffDistance = radii2[id];  // squared radii of the supports
 
-          Real dist = calculateDistance(target_coords, support_coords, dim);
+        for (LO d = 0; d < dim; ++d) {
+          current_target_coords[d] = target_coords[id * dim + d];
+        }
+
+        // candidate slot of the current target vertex
+        const LO start_counter = slot_ptr[k];
+        const LO slot_size = slot_ptr[k + 1] - start_counter;
+        int count = 0;  // number of supports for the current target vertex
+
+        // marks the source as visited and queues it if it is a support
+        auto visit = [&](const LO source) {
+          if (!visited.insert(source)) {
+            return;
+          }
+          for (LO d = 0; d < dim; ++d) {
+            support_coords[d] = source_coords[source * dim + d];
+          }
+          Real dist =
+              calculateDistance(current_target_coords, support_coords, dim);
           if (dist <= cutoffDistance) {
-            count++;
-            queue.push_back(vert_id);
-            if (support_idx.size() > 0) {
-              LO idx_count = count - 1;
-              support_idx[start_counter + idx_count] = vert_id;
+            if (count < slot_size) {
+              candidates[start_counter + count] = source;
             }
+            count++;
+            queue.push_back(source);
           }
+        };
+
+        // Initialize queue by visiting the seeds of the given target point
+        for (LO i = seed_ptr[id]; i < seed_ptr[id + 1]; ++i) {
+          visit(seed_data[i]);
         }
 
+        // loops over the queued supports and visits their neighbors
         while (!queue.isEmpty()) {
-          LO currentVertex = queue.front();
+          LO current = queue.front();
           queue.pop_front();
-          LO start = v2v_ptr[currentVertex];
-          LO end = v2v_ptr[currentVertex + 1];
-
-          for (LO i = start; i < end; ++i) {
-            auto neighborIndex = v2v_data[i];
-
-            // check if neighbor index is already in the queue to be checked
-            // TODO refactor this into a function
-
-            if (visited.notVisited(neighborIndex)) {
-              visited.push_back(neighborIndex);
-              for (int k = 0; k < dim; ++k) {
-                support_coords[k] =
-                    sourcePoints_coords[neighborIndex * dim + k];
-              }
-
-              Real dist = calculateDistance(target_coords, support_coords, dim);
-
-              if (dist <= cutoffDistance) {
-                count++;
-                queue.push_back(neighborIndex);
-                if (support_idx.size() > 0) {
-                  LO idx_count = count - 1;
-                  support_idx[start_counter + idx_count] = neighborIndex;
-                }
-              }
-            }
+          for (LO j = adj_ptr[current]; j < adj_ptr[current + 1]; ++j) {
+            visit(adj_data[j]);
           }
-        }  // end of while loop
+        }
 
-        nSupports[id] = count;
+        nSupports[k] = count;
+        overflowed[k] = queue.overflowed() || visited.overflowed();
       },
       "count the number of supports in each target point");
+
+  return get_max(LOs(overflowed)) > 0;
 }
 
 struct SupportResults {
   Write<LO> supports_ptr;
   Write<LO> supports_idx;
+  Write<Real> radii2;  // squared radii of the supports
 };
 
-SupportResults searchNeighbors(Mesh& source_mesh, Mesh& target_mesh,
-                               Real& cutoffDistance) {
+// finds at least min_support and at most max_support supports for each
+// target vertex, starting from the cutoff distance. The radius of the targets
+// outside that range is rescaled and only those targets are searched again,
+// until all targets are in range or max_iterations is reached. Targets outside
+// of the source mesh and targets whose radius reached the maximum radius of the
+// search can not find more supports and are not searched again
+inline SupportResults searchNeighbors(
+    FindSupports& search, Real cutoffDistance, LO min_support = 20,
+    LO max_support = std::numeric_limits<LO>::max(), int max_iterations = 10) {
+  OMEGA_H_CHECK(min_support <= max_support);
   SupportResults support;
 
-  FindSupports search(source_mesh, target_mesh);
-
-  LO nvertices_source = source_mesh.nverts();
-
-  LO nvertices_target = target_mesh.nverts();
+  LO nvertices_target = search.ntargets();
 
-  Write<LO> nSupports(nvertices_target, 0,
-                      "number of supports in each target vertex");
+  support.radii2 = Write<Real>(nvertices_target, cutoffDistance,
+                               "squared radii of the supports");
 
-  search.adjBasedSearch(cutoffDistance, support.supports_ptr, nSupports,
+  // this call gets the supports of each target vertex in CSR format
+  const LOs all_targets(nvertices_target, 0, 1, "all target vertices");
+  search.adjBasedSearch(all_targets, support.radii2, support.supports_ptr,
                         support.supports_idx);
 
-  Kokkos::fence();
-
-  support.supports_ptr =
-      Write<LO>(nvertices_target + 1, 0,
-                "number of support source vertices in CSR format");
-
-  LO total_supports = 0;
-
-  Kokkos::parallel_scan(
-      nvertices_target,
-      OMEGA_H_LAMBDA(int j, int& update, bool final) {
-        update += nSupports[j];
-        if (final) {
-          support.supports_ptr[j + 1] = update;
-        }
-      },
-      total_supports);
+  const auto seed_ptr = search.seedOffsets();
+  const auto max_radius2 = search.maxRadius2();
+  const auto radii2 = support.radii2;
+  for (int iteration = 0; iteration < max_iterations; ++iteration) {
+    const auto supports_ptr = support.supports_ptr;
+    const auto supports_idx = support.supports_idx;
+    Write<I8> is_deficient(nvertices_target, "targets out of support range");
+    parallel_for(
+        nvertices_target, OMEGA_H_LAMBDA(const LO i) {
+          const LO n = supports_ptr[i + 1] - supports_ptr[i];
+          const bool can_grow =
+              seed_ptr[i + 1] > seed_ptr[i] && radii2[i] < max_radius2;
+          is_deficient[i] = (n < min_support && can_grow) || n > max_support;
+        });
+    const auto worklist = collect_marked(Read<I8>(is_deficient));
+    const LO ndeficient = worklist.size();
+    if (ndeficient == 0) {
+      break;
+    }
+
+    // the number of supports grows with the area of the support, so the
+    // squared radius is scaled by the ratio of the wanted to the found count.
+    // A target without any supports doubles its radius
+    parallel_for(
+        ndeficient, OMEGA_H_LAMBDA(const LO k) {
+          const LO i = worklist[k];
+          const LO n = supports_ptr[i + 1] - supports_ptr[i];
+          if (n == 0) {
+            radii2[i] *= 4;
+          } else if (n < min_support) {
+            radii2[i] *= Real(min_support) / n;
+          } else {
+            radii2[i] *= Real(max_support) / n;
+          }
+          radii2[i] = radii2[i] < max_radius2 ? radii2[i] : max_radius2;
+        });
+
+    // the supports of the worklist are stored in their own CSR, so the
+    // retries never allocate for the targets that are already in range
+    Write<LO> wl_supports_ptr;
+    Write<LO> wl_supports_idx;
+    search.adjBasedSearch(worklist, radii2, wl_supports_ptr, wl_supports_idx);
+
+    // merge the supports of the worklist into the supports of all targets
+    Write<LO> wl_index(nvertices_target, -1, "worklist index of each target");
+    parallel_for(
+        ndeficient, OMEGA_H_LAMBDA(const LO k) { wl_index[worklist[k]] = k; });
+    Write<LO> nSupports(nvertices_target,
+                        "number of supports in each target vertex");
+    parallel_for(
+        nvertices_target, OMEGA_H_LAMBDA(const LO i) {
+          const LO k = wl_index[i];
+          nSupports[i] = k < 0 ? supports_ptr[i + 1] - supports_ptr[i]
+                               : wl_supports_ptr[k + 1] - wl_supports_ptr[k];
+        });
+    const auto merged_ptr = offset_scan(LOs(nSupports));
+    Write<LO> merged_idx(merged_ptr.last(),
+                         "index of source supports of each target node");
+    parallel_for(
+        nvertices_target, OMEGA_H_LAMBDA(const LO i) {
+          const LO k = wl_index[i];
+          const LO start = k < 0 ? supports_ptr[i] : wl_supports_ptr[k];
+          const auto& from = k < 0 ? supports_idx : wl_supports_idx;
+          for (LO j = 0; j < nSupports[i]; ++j) {
+            merged_idx[merged_ptr[i] + j] = from[start + j];
+          }
+        });
+    support.supports_ptr = deep_copy(merged_ptr);
+    support.supports_idx = merged_idx;
+  }
 
-  Kokkos::fence();
+  const auto supports_ptr = support.supports_ptr;
+  Write<LO> out_of_range(nvertices_target, "targets out of support range");
+  parallel_for(
+      nvertices_target, OMEGA_H_LAMBDA(const LO i) {
+        const LO n = supports_ptr[i + 1] - supports_ptr[i];
+        out_of_range[i] = n < min_support || n > max_support;
+      });
+  const LO nout_of_range = get_sum(LOs(out_of_range));
+  if (nout_of_range > 0) {
+    std::cerr << "WARNING: " << nout_of_range
+              << " target vertices are out of the support range ["
+              << min_support << ", " << max_support << "]\n";
+  }
 
-  support.supports_idx = Write<LO>(
-      total_supports, 0, "index of source supports of each target node");
+  return support;
+}
 
-  search.adjBasedSearch(cutoffDistance, support.supports_ptr, nSupports,
-                        support.supports_idx);
+// supports of the vertices of the mesh among its cell centroids
+inline SupportResults searchNeighbors(
+    Mesh& mesh, Real& cutoffDistance, LO min_support = 20,
+    LO max_support = std::numeric_limits<LO>::max(), int max_iterations = 10) {
+  FindSupports search(mesh);
+  return searchNeighbors(search, cutoffDistance, min_support, max_support,
+                         max_iterations);
+}
 
-  return support;
+// supports of the vertices of the target mesh among the source vertices
+// within the fixed cutoff distance. Growing the radius of the targets with
+// fewer supports is opt in by passing a nonzero min_support
+inline SupportResults searchNeighbors(
+    Mesh& source_mesh, Mesh& target_mesh, Real& cutoffDistance,
+    LO min_support = 0, LO max_support = std::numeric_limits<LO>::max(),
+    int max_iterations = 10) {
+  FindSupports search(source_mesh, target_mesh);
+  return searchNeighbors(search, cutoffDistance, min_support, max_support,
+                         max_iterations);
 }
 
 #endif
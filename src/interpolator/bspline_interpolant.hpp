@@ -0,0 +1,162 @@
+#ifndef BSPLINE_INTERPOLANT_HPP
+#define BSPLINE_INTERPOLANT_HPP
+
+#include <cmath>
+#include "linear_interpolant.hpp"
+
+// pole of the cubic B-spline prefilter
+static constexpr double bspline_pole = -0.26794919243112270; // sqrt(3) - 2
+
+// index of a grid node with the grid mirrored at both ends
+KOKKOS_INLINE_FUNCTION
+int mirror_index(int k, int n){
+    if (n == 1){
+        return 0;
+    }
+    const int period = 2 * (n - 1);
+    k = k % period;
+    if (k < 0){
+        k += period;
+    }
+    return k < n ? k : period - k;
+}
+
+// in place recursive filter that turns the samples of a line of the grid
+// into the coefficients of the cubic B-spline interpolating them, with mirror
+// boundary conditions
+KOKKOS_INLINE_FUNCTION
+void bspline_prefilter_line(const RealVecView& coefficients, int start, int stride, int n){
+    if (n == 1){
+        return;
+    }
+    const double z = bspline_pole;
+    const double lambda = (1 - z) * (1 - 1 / z);
+    auto c = [&](int k) -> double& { return coefficients(start + k * stride); };
+
+    for (int k = 0; k < n; ++k){
+        c(k) *= lambda;
+    }
+
+    // causal initialization for the mirrored (period 2n - 2) signal
+    double zk = z;
+    double z2n = std::pow(z, 2 * n - 2);
+    double sum = c(0) + std::pow(z, n - 1) * c(n - 1);
+    for (int k = 1; k < n - 1; ++k){
+        sum += (zk + z2n / zk) * c(k);
+        zk *= z;
+    }
+    c(0) = sum / (1 - z2n);
+    for (int k = 1; k < n; ++k){
+        c(k) += z * c(k - 1);
+    }
+
+    // anticausal initialization and filter
+    c(n - 1) = (z / (z * z - 1)) * (c(n - 1) + z * c(n - 2));
+    for (int k = n - 2; k >= 0; --k){
+        c(k) = z * (c(k + 1) - c(k));
+    }
+}
+
+// coefficients of the cubic B-spline that interpolates the row major values
+// of a grid with the given number of nodes in each dimension. The filter is
+// separable, so it runs along every line of the grid one dimension at a time
+inline RealVecView bspline_coefficients(const RealVecView& values, const IntVecView& dimensions){
+    auto dimensions_h = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), dimensions);
+    int dim = dimensions_h.extent(0);
+    int total_size = values.extent(0);
+
+    RealVecView coefficients("bspline coefficients", total_size);
+    Kokkos::deep_copy(coefficients, values);
+
+    int stride = total_size;
+    for (int i = 0; i < dim; ++i){
+        const int n = dimensions_h(i);
+        stride /= n;
+        const int line_stride = stride;
+        const int nlines = total_size / n;
+        Kokkos::parallel_for("bspline prefilter", nlines, KOKKOS_LAMBDA(int line){
+            int outer = line / line_stride;
+            int inner = line % line_stride;
+            bspline_prefilter_line(coefficients, outer * line_stride * n + inner, line_stride, n);
+        });
+    }
+    return coefficients;
+}
+
+// weights of the four B-splines that overlap the parametric coordinate t of
+// a cell, for the nodes i - 1 to i + 2
+KOKKOS_INLINE_FUNCTION
+void cubic_bspline_weights(double t, double* weights){
+    double t2 = t * t;
+    double t3 = t2 * t;
+    double s = 1 - t;
+    weights[0] = s * s * s / 6;
+    weights[1] = (3 * t3 - 6 * t2 + 4) / 6;
+    weights[2] = (-3 * t3 + 3 * t2 + 3 * t + 1) / 6;
+    weights[3] = t3 / 6;
+}
+
+// cubic B-spline interpolation on a uniform grid of compile time dimension.
+// The coefficients are computed once by the prefilter, so a coarser grid than
+// the multilinear interpolation needs reaches the same accuracy
+template <int Dim>
+class BSplineGridInterpolator {
+    static_assert(Dim > 0 && Dim <= MAX_DIM, "unsupported grid dimension");
+    static constexpr int num_terms = 1 << (2 * Dim); // 4^Dim
+
+    private:
+        const IntVecView num_bins;
+        const RealVecView range;
+        const IntVecView dimensions;
+        const GridCorners<Dim> corners;
+        RealVecView coefficients;
+
+    public:
+        BSplineGridInterpolator(const IntVecView& num_bins_, const RealVecView& range_,
+                                const RealVecView& values_)
+                                : num_bins(num_bins_), range(range_),
+                                  dimensions(grid_dimensions(num_bins_)), corners(dimensions),
+                                  coefficients(bspline_coefficients(values_, dimensions)) {};
+
+        RealVecView interpolate(const RealMatView& points) const {
+            int N = points.extent(0);
+            RealVecView interpolated_values("approximated values", N);
+            auto num_bins_ = num_bins;
+            auto range_ = range;
+            auto dimensions_ = dimensions;
+            auto corners_ = corners;
+            auto coefficients_ = coefficients;
+            Kokkos::parallel_for("bspline interpolation", N, KOKKOS_LAMBDA(int j){
+                double weights[Dim][4];
+                int nodes[Dim][4];
+                for (int i = 0; i < Dim; ++i){
+                    int id = i * 2;
+                    int n = dimensions_(i);
+                    double dlen = (range_(id + 1) - range_(id)) / num_bins_(i);
+                    double position = (points(j, i) - range_(id)) / dlen;
+                    int cell = std::floor(position);
+                    cell = cell > n - 2 ? n - 2 : cell;
+                    cell = cell < 0 ? 0 : cell; // also a single node dimension
+                    cubic_bspline_weights(position - cell, weights[i]);
+                    for (int k = 0; k < 4; ++k){
+                        nodes[i][k] = mirror_index(cell + k - 1, n);
+                    }
+                }
+                double sum = 0;
+                for (int term = 0; term < num_terms; ++term){
+                    double temp = 1.0;
+                    int index = 0;
+                    for (int i = 0; i < Dim; ++i){
+                        int k = (term >> (2 * i)) & 3;
+                        temp *= weights[i][k];
+                        index += nodes[i][k] * corners_.strides[i];
+                    }
+                    sum += temp * coefficients_(index);
+                }
+                interpolated_values(j) = sum;
+            });
+            return interpolated_values;
+        }
+};
+
+#endif
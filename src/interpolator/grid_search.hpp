@@ -0,0 +1,284 @@
+#ifndef GRID_SEARCH_HPP
+#define GRID_SEARCH_HPP
+
+#include <Omega_h_array_ops.hpp>
+#include <Omega_h_scan.hpp>
+#include <pcms/uniform_grid.h>
+
+#include <cmath>
+
+#include "adj_search.hpp"
+
+using namespace Omega_h;
+
+// largest number of neighbors the kNN search can collect for a target
+static constexpr int max_knn = 64;
+
+// support search over a uniform grid index of the source points. Unlike the
+// adjacency based search it does not need mesh connectivity, so it works
+// across holes in the mesh and for point clouds without a mesh
+class GridSupportSearch {
+ public:
+  // source_coordinates are the interleaved 2D coordinates of the source
+  // points. The grid is sized to hold about points_per_cell points per cell
+  GridSupportSearch(const Reals& source_coordinates, LO dim = 2,
+                    LO points_per_cell = 4);
+
+  // supports of each target are the source points within the cutoff distance
+  SupportResults radiusSearch(const Reals& target_coordinates,
+                              Real cutoffDistance) const;
+
+  // supports of each target are its k nearest source points. The squared
+  // radius of each target is radius_scale times the squared distance to the
+  // kth neighbor, so that the farthest support still has a nonzero weight
+  SupportResults knnSearch(const Reals& target_coordinates, LO k,
+                           Real radius_scale = 1.1) const;
+
+ private:
+  pcms::UniformGrid grid_;
+  Reals source_coords_;
+  LOs cell_ptr_;     // start of the source points of each grid cell
+  LOs cell_points_;  // source points sorted by grid cell
+};
+
+// row or column of the grid cell that holds the coordinate along direction d,
+// clamped to the grid
+KOKKOS_INLINE_FUNCTION
+LO grid_cell_coordinate(const pcms::UniformGrid& grid, Real x, int d) {
+  const Real distance_within_grid = x - grid.bot_left[d];
+  LO index = static_cast<LO>(std::floor(
+      distance_within_grid * grid.divisions[d] / grid.edge_length[d]));
+  if (index < 0) {
+    index = 0;
+  }
+  if (index > grid.divisions[d] - 1) {
+    index = grid.divisions[d] - 1;
+  }
+  return index;
+}
+
+// calls found for each source point within the squared cutoff distance of the
+// target
+template <typename Found>
+KOKKOS_INLINE_FUNCTION void for_each_grid_support(
+    const pcms::UniformGrid& grid, const Reals& coords, const LOs& cell_ptr,
+    const LOs& cell_points, const Real* target, Real cutoffDistance,
+    Found&& found) {
+  const Real cutoff = std::sqrt(cutoffDistance);
+  const LO row_begin = grid_cell_coordinate(grid, target[1] - cutoff, 1);
+  const LO row_end = grid_cell_coordinate(grid, target[1] + cutoff, 1);
+  const LO col_begin = grid_cell_coordinate(grid, target[0] - cutoff, 0);
+  const LO col_end = grid_cell_coordinate(grid, target[0] + cutoff, 0);
+  for (LO row = row_begin; row <= row_end; ++row) {
+    for (LO col = col_begin; col <= col_end; ++col) {
+      const LO cell = grid.GetCellIndex(row, col);
+      for (LO j = cell_ptr[cell]; j < cell_ptr[cell + 1]; ++j) {
+        const LO source = cell_points[j];
+        const Real source_coords[2] = {coords[source * 2],
+                                       coords[source * 2 + 1]};
+        if (calculateDistance(target, source_coords, 2) <= cutoffDistance) {
+          found(source);
+        }
+      }
+    }
+  }
+}
+
+namespace detail {
+// counting sort of the points by the grid cell that holds them. The sorting
+// kernels are kept out of the GridSupportSearch constructor, since device
+// lambdas can not be defined in constructors
+inline void bin_points(const pcms::UniformGrid& grid, const Reals& coords,
+                       LOs& cell_ptr, LOs& cell_points) {
+  const LO npoints = coords.size() / 2;
+  const auto ncells = grid.GetNumCells();
+  Write<LO> point_cells(npoints, "grid cell of each source point");
+  Write<LO> cell_counts(ncells, 0, "number of source points in each cell");
+  parallel_for(
+      npoints, OMEGA_H_LAMBDA(const LO i) {
+        const LO cell = grid.ClosestCellID(
+            Omega_h::Vector<2>{coords[i * 2], coords[i * 2 + 1]});
+        point_cells[i] = cell;
+        Kokkos::atomic_add(&cell_counts[cell], 1);
+      });
+
+  cell_ptr = offset_scan(LOs(cell_counts));
+  const auto sorted_ptr = cell_ptr;
+  Write<LO> cell_fill(ncells, 0, "filled source points of each cell");
+  Write<LO> sorted_points(npoints, "source points sorted by grid cell");
+  parallel_for(
+      npoints, OMEGA_H_LAMBDA(const LO i) {
+        const LO cell = point_cells[i];
+        const LO offset = Kokkos::atomic_fetch_add(&cell_fill[cell], 1);
+        sorted_points[sorted_ptr[cell] + offset] = i;
+      });
+  cell_points = sorted_points;
+}
+}  // namespace detail
+
+inline GridSupportSearch::GridSupportSearch(const Reals& source_coordinates,
+                                            LO dim, LO points_per_cell)
+    : source_coords_(source_coordinates) {
+  OMEGA_H_CHECK(dim == pcms::UniformGrid::dim);
+  OMEGA_H_CHECK(points_per_cell > 0);
+  const LO npoints = source_coordinates.size() / dim;
+  OMEGA_H_CHECK(npoints > 0);
+
+  Real area = 1;
+  for (int d = 0; d < dim; ++d) {
+    const auto component = get_component(source_coordinates, dim, d);
+    const Real min = get_min(component);
+    Real extent = get_max(component) - min;
+    if (extent <= 0) {
+      extent = 1;  // all points lie on a line
+    }
+    grid_.bot_left[d] = min;
+    grid_.edge_length[d] = extent;
+    area *= extent;
+  }
+
+  const Real cell_width = std::sqrt(area * points_per_cell / npoints);
+  for (int d = 0; d < dim; ++d) {
+    grid_.divisions[d] = std::max(
+        LO(1), static_cast<LO>(std::ceil(grid_.edge_length[d] / cell_width)));
+  }
+
+  ::detail::bin_points(grid_, source_coords_, cell_ptr_, cell_points_);
+}
+
+inline SupportResults GridSupportSearch::radiusSearch(
+    const Reals& target_coordinates, Real cutoffDistance) const {
+  const LO ntargets = target_coordinates.size() / 2;
+  const auto grid = grid_;
+  const auto coords = source_coords_;
+  const auto cell_ptr = cell_ptr_;
+  const auto cell_points = cell_points_;
+
+  Write<LO> nSupports(ntargets, "number of supports in each target");
+  parallel_for(
+      ntargets, OMEGA_H_LAMBDA(const LO id) {
+        const Real target[2] = {target_coordinates[id * 2],
+                                target_coordinates[id * 2 + 1]};
+        LO count = 0;
+        for_each_grid_support(grid, coords, cell_ptr, cell_points, target,
+                              cutoffDistance, [&](LO) { ++count; });
+        nSupports[id] = count;
+      });
+
+  const auto offsets = offset_scan(LOs(nSupports));
+  SupportResults support;
+  support.supports_ptr = deep_copy(offsets);
+  support.supports_idx =
+      Write<LO>(offsets.last(), "index of source supports of each target");
+  support.radii2 =
+      Write<Real>(ntargets, cutoffDistance, "squared radii of the supports");
+
+  const auto supports_ptr = support.supports_ptr;
+  const auto supports_idx = support.supports_idx;
+  parallel_for(
+      ntargets, OMEGA_H_LAMBDA(const LO id) {
+        const Real target[2] = {target_coordinates[id * 2],
+                                target_coordinates[id * 2 + 1]};
+        LO position = supports_ptr[id];
+        for_each_grid_support(
+            grid, coords, cell_ptr, cell_points, target, cutoffDistance,
+            [&](LO source) { supports_idx[position++] = source; });
+      });
+
+  return support;
+}
+
+inline SupportResults GridSupportSearch::knnSearch(
+    const Reals& target_coordinates, LO k, Real radius_scale) const {
+  OMEGA_H_CHECK(k > 0 && k <= max_knn);
+  const LO ntargets = target_coordinates.size() / 2;
+  const LO npoints = source_coords_.size() / 2;
+  const LO nneighbors = k < npoints ? k : npoints;
+  const auto grid = grid_;
+  const auto coords = source_coords_;
+  const auto cell_ptr = cell_ptr_;
+  const auto cell_points = cell_points_;
+  const Real min_cell_width =
+      std::min(grid.edge_length[0] / grid.divisions[0],
+               grid.edge_length[1] / grid.divisions[1]);
+  const LO max_ring = std::max(grid.divisions[0], grid.divisions[1]);
+  // coincident points put the kth neighbor at distance 0, which would give
+  // the supports a zero radius and a division by zero in the RBF
+  const Real min_radius2 = 1e-12 * min_cell_width * min_cell_width;
+
+  SupportResults support;
+  support.supports_ptr = deep_copy(LOs(ntargets + 1, 0, nneighbors));
+  support.supports_idx = Write<LO>(ntargets * nneighbors,
+                                   "index of source supports of each target");
+  support.radii2 = Write<Real>(ntargets, "squared radii of the supports");
+
+  const auto supports_idx = support.supports_idx;
+  const auto radii2 = support.radii2;
+  parallel_for(
+      ntargets, OMEGA_H_LAMBDA(const LO id) {
+        // nearest neighbors found so far, sorted by distance
+        Real distances[max_knn];
+        LO neighbors[max_knn];
+        LO nfound = 0;
+
+        const Real target[2] = {target_coordinates[id * 2],
+                                target_coordinates[id * 2 + 1]};
+        const LO target_row = grid_cell_coordinate(grid, target[1], 1);
+        const LO target_col = grid_cell_coordinate(grid, target[0], 0);
+
+        // visit the rings of cells around the target cell until the points in
+        // the unvisited rings can not be closer than the kth neighbor
+        for (LO ring = 0; ring <= max_ring; ++ring) {
+          if (nfound == nneighbors) {
+            const Real ring_distance = (ring - 1) * min_cell_width;
+            if (distances[nfound - 1] <= ring_distance * ring_distance) {
+              break;
+            }
+          }
+          for (LO row = target_row - ring; row <= target_row + ring; ++row) {
+            if (row < 0 || row >= grid.divisions[1]) {
+              continue;
+            }
+            const bool edge_row =
+                row == target_row - ring || row == target_row + ring;
+            const LO col_step = edge_row || ring == 0 ? 1 : 2 * ring;
+            for (LO col = target_col - ring; col <= target_col + ring;
+                 col += col_step) {
+              if (col < 0 || col >= grid.divisions[0]) {
+                continue;
+              }
+              const LO cell = grid.GetCellIndex(row, col);
+              for (LO j = cell_ptr[cell]; j < cell_ptr[cell + 1]; ++j) {
+                const LO source = cell_points[j];
+                const Real source_coords[2] = {coords[source * 2],
+                                               coords[source * 2 + 1]};
+                const Real dist =
+                    calculateDistance(target, source_coords, 2);
+                if (nfound == nneighbors && dist >= distances[nfound - 1]) {
+                  continue;
+                }
+                // insertion into the sorted neighbor list
+                LO position = nfound < nneighbors ? nfound++ : nfound - 1;
+                while (position > 0 && distances[position - 1] > dist) {
+                  distances[position] = distances[position - 1];
+                  neighbors[position] = neighbors[position - 1];
+                  --position;
+                }
+                distances[position] = dist;
+                neighbors[position] = source;
+              }
+            }
+          }
+        }
+
+        for (LO j = 0; j < nfound; ++j) {
+          supports_idx[id * nneighbors + j] = neighbors[j];
+        }
+        const Real radius2 = radius_scale * distances[nfound - 1];
+        radii2[id] = radius2 > min_radius2 ? radius2 : min_radius2;
+      });
+
+  return support;
+}
+
+#endif
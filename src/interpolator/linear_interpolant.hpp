@@ -3,10 +3,27 @@
 #define INTERPOLANT_HPP 
 
 
+#include <cassert>
+#include <cmath>
 #include <iostream>
 #include "multidimarray.hpp"
 #define MAX_DIM 10
 
+// handling of the points outside of the grid
+enum class OutOfBounds {
+    CLAMP,       // value at the closest point of the grid
+    EXTRAPOLATE, // linear extrapolation of the closest boundary cell
+    FILL         // fill value
+};
+
+// cell index of a position given in cells from the start of the range,
+// limited to the cells of the grid
+KOKKOS_INLINE_FUNCTION
+int clamp_cell(double position, int num_bins){
+    int index = position;
+    index = index < 0 ? 0 : index;
+    return index > num_bins - 1 ? num_bins - 1 : index;
+}
 
 KOKKOS_INLINE_FUNCTION
 void find_indices(const IntVecView& num_bins,  const RealVecView& range,
@@ -17,7 +34,7 @@ void find_indices(const IntVecView& num_bins,  const RealVecView& range,
         int id = i * 2;
         double length = range(id + 1) - range(id);
         double dlen = length/num_bins(i);
-        indices[i] = ((point(i) - range(id)) / dlen);
+        indices[i] = clamp_cell((point(i) - range(id)) / dlen, num_bins(i));
         
     }
 
@@ -32,7 +49,7 @@ void find_limits(const IntVecView& num_bins,  const RealVecView& range, const in
     for (int i = 0; i < dim; ++i){
 	int ptr = i * 2;
 	double dlen = (range(ptr+1) - range(ptr))/num_bins(i);
-	limits[ptr] = indices[i] * dlen;
+	limits[ptr] = range(ptr) + indices[i] * dlen;
 	limits[ptr+1] = limits[ptr] + dlen;
     }
 }
@@ -101,7 +118,175 @@ double linear_interpolant(const IntVecView& dimensions, const double* linear_bas
 
 
 
+// number of nodes in each dimension of a uniform grid with the given number
+// of cells in each dimension
+inline IntVecView grid_dimensions(const IntVecView& num_bins){
+    int dim = num_bins.extent(0);
+    IntVecView dimensions("grid dimensions", dim);
+    Kokkos::parallel_for(dim, KOKKOS_LAMBDA(int i){
+        dimensions(i) = num_bins(i) + 1;
+    });
+    return dimensions;
+}
+
+// grid dimension known only at run time
+static constexpr int dynamic_dim = -1;
+
+// corner offsets and strides of a grid of compile time dimension. Since the
+// loops over the dimensions and corners have compile time trip counts they
+// are fully unrolled
+template <int Dim>
+struct GridCorners {
+    static_assert(Dim > 0 && Dim <= MAX_DIM, "unsupported grid dimension");
+    static constexpr int num_corners = 1 << Dim;
+    // index stride of each dimension in the row major values
+    Kokkos::Array<int, Dim> strides;
+    // offset of each cell corner from the lower corner of the cell. A
+    // dimension with a single node has no upper corner, so its corners share
+    // the offset of the lower one
+    Kokkos::Array<int, num_corners> offsets;
+
+    explicit GridCorners(const IntVecView& dimensions){
+        auto dimensions_h = Kokkos::create_mirror_view_and_copy(
+            Kokkos::HostSpace(), dimensions);
+        int multiplier = 1;
+        for (int i = Dim - 1; i >= 0; --i){
+            strides[i] = multiplier;
+            multiplier *= dimensions_h(i);
+        }
+        for (int corner = 0; corner < num_corners; ++corner){
+            offsets[corner] = 0;
+            for (int i = 0; i < Dim; ++i){
+                if ((corner & (1 << i)) && dimensions_h(i) > 1){
+                    offsets[corner] += strides[i];
+                }
+            }
+        }
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    int lower_corner(const int* indices) const {
+        int index = 0;
+        for (int i = 0; i < Dim; ++i){
+            index += indices[i] * strides[i];
+        }
+        return index;
+    }
+};
+
+// multilinear weight of each corner of a cell
+template <int Dim>
+KOKKOS_INLINE_FUNCTION
+void corner_weights(const double* parametric_coord, double* weights){
+    double linear_basis_each_dir[Dim][2];
+    for (int i = 0; i < Dim; ++i){
+        linear_basis_each_dir[i][0] = 1 - parametric_coord[i];
+        linear_basis_each_dir[i][1] = parametric_coord[i];
+    }
+    for (int corner = 0; corner < GridCorners<Dim>::num_corners; ++corner){
+        double temp = 1.0;
+        for (int i = 0; i < Dim; ++i){
+            temp *= linear_basis_each_dir[i][(corner >> i) & 1];
+        }
+        weights[corner] = temp;
+    }
+}
+
+// multilinear interpolant of the cell whose lower corner is at lower_corner
+template <int Dim>
+KOKKOS_INLINE_FUNCTION
+double linear_interpolant(const GridCorners<Dim>& corners, const double* parametric_coord,
+    int lower_corner, const RealVecView& values){
+    double weights[GridCorners<Dim>::num_corners];
+    corner_weights<Dim>(parametric_coord, weights);
+    double sum = 0;
+    for (int corner = 0; corner < GridCorners<Dim>::num_corners; ++corner){
+        sum += weights[corner] * values(lower_corner + corners.offsets[corner]);
+    }
+    return sum;
+}
+
+// interpolator for a grid of compile time dimension Dim
+template <int Dim = dynamic_dim>
 class RegularGridInterpolator {
+    private:
+        const RealMatView parametric_coords;
+        const RealVecView values;
+        const IntMatView indices;
+        const GridCorners<Dim> corners;
+
+    public:
+        RegularGridInterpolator(const RealMatView& parametric_coords_,
+                            const RealVecView& values_, const IntMatView& indices_, const IntVecView& dimensions_)
+                            : parametric_coords(parametric_coords_), values(values_), indices(indices_), corners(dimensions_) {
+            assert(static_cast<int>(dimensions_.extent(0)) == Dim);
+        };
+
+RealVecView linear_interpolation() {
+	    int N = parametric_coords.extent(0);
+	    RealVecView interpolated_values("approximated values", N);
+	    auto parametric_coords_ = parametric_coords;
+	    auto values_ = values;
+	    auto indices_ = indices;
+	    auto corners_ = corners;
+	    Kokkos::parallel_for("linear interpolation function",N, KOKKOS_LAMBDA(int j){
+		double parametric_coord[Dim];
+		int index[Dim];
+		for (int i = 0; i < Dim; ++i){
+		    parametric_coord[i] = parametric_coords_(j, i);
+		    index[i] = indices_(j, i);
+		}
+		interpolated_values(j) = linear_interpolant(corners_, parametric_coord,
+		    corners_.lower_corner(index), values_);
+	    });
+
+	    return interpolated_values;
+	}
+
+// interpolates K quantities on the same grid, given as (gridsize x K) values,
+// and returns (N x K) values. The corner weights of each point are computed
+// once for all K quantities, and the K loop runs over the vector lanes
+RealMatView linear_interpolation(const RealMatView& batched_values) const {
+	    int N = parametric_coords.extent(0);
+	    int K = batched_values.extent(1);
+	    RealMatView interpolated_values("approximated values", N, K);
+	    auto parametric_coords_ = parametric_coords;
+	    auto indices_ = indices;
+	    auto corners_ = corners;
+
+	    using policy_type = Kokkos::TeamPolicy<>;
+	    int vector_length = 1;
+	    while (2 * vector_length <= K && 2 * vector_length <= policy_type::vector_length_max()){
+		vector_length *= 2;
+	    }
+	    Kokkos::parallel_for("batched linear interpolation", policy_type(N, 1, vector_length),
+		KOKKOS_LAMBDA(const policy_type::member_type& team){
+		int j = team.league_rank();
+		double parametric_coord[Dim];
+		int index[Dim];
+		for (int i = 0; i < Dim; ++i){
+		    parametric_coord[i] = parametric_coords_(j, i);
+		    index[i] = indices_(j, i);
+		}
+		double weights[GridCorners<Dim>::num_corners];
+		corner_weights<Dim>(parametric_coord, weights);
+		int lower_corner = corners_.lower_corner(index);
+		Kokkos::parallel_for(Kokkos::ThreadVectorRange(team, K), [&](int k){
+		    double sum = 0;
+		    for (int corner = 0; corner < GridCorners<Dim>::num_corners; ++corner){
+			sum += weights[corner] * batched_values(lower_corner + corners_.offsets[corner], k);
+		    }
+		    interpolated_values(j, k) = sum;
+		});
+	    });
+
+	    return interpolated_values;
+	}
+};
+
+// interpolator for a grid whose dimension is only known at run time
+template <>
+class RegularGridInterpolator<dynamic_dim> {
     private:
         const RealMatView parametric_coords;
         const RealVecView values;
@@ -167,6 +352,139 @@ Result parametric_indices(const RealMatView& points, const IntVecView& num_bins,
     
 }
 
+// cell indices and parametric coordinates of a point in a uniform grid of
+// compile time dimension. The indices are always limited to the grid, the
+// policy decides whether the parametric coordinates are limited too. Returns
+// false if the point is outside of the grid, which is only checked for FILL
+template <int Dim, OutOfBounds Policy = OutOfBounds::EXTRAPOLATE>
+KOKKOS_INLINE_FUNCTION
+bool locate_point(const IntVecView& num_bins, const RealVecView& range,
+    const double* point, int* indices, double* parametric_coord){
+    bool inside = true;
+    for (int i = 0; i < Dim; ++i){
+        int id = i * 2;
+        double dlen = (range(id + 1) - range(id)) / num_bins(i);
+        double position = (point[i] - range(id)) / dlen;
+        if constexpr (Policy == OutOfBounds::CLAMP){
+            position = std::fmin(std::fmax(position, 0.0), double(num_bins(i)));
+        }
+        if constexpr (Policy == OutOfBounds::FILL){
+            inside = inside && position >= 0 && position <= num_bins(i);
+        }
+        indices[i] = clamp_cell(position, num_bins(i));
+        parametric_coord[i] = position - indices[i];
+    }
+    return inside;
+}
+
+// locates the points in the uniform grid and interpolates the values in a
+// single kernel, so the indices and parametric coordinates of the points do
+// not make a round trip through memory. They are only stored if intermediate
+// is given. Points outside of the grid are handled by the Policy, with
+// fill_value used by OutOfBounds::FILL
+template <int Dim, OutOfBounds Policy = OutOfBounds::EXTRAPOLATE>
+RealVecView interpolate_regular_grid(const RealMatView& points, const IntVecView& num_bins,
+    const RealVecView& range, const RealVecView& values, Result* intermediate = nullptr,
+    double fill_value = 0){
+    int N = points.extent(0);
+    const GridCorners<Dim> corners(grid_dimensions(num_bins));
+
+    const bool keep_intermediate = intermediate != nullptr;
+    Result result;
+    if (keep_intermediate){
+        result.indices_pts = IntMatView("indices", N, Dim);
+        result.parametric_coords = RealMatView("parametric_coordinates", N, Dim);
+    }
+
+    RealVecView interpolated_values("approximated values", N);
+    Kokkos::parallel_for("locate and interpolate", N, KOKKOS_LAMBDA(int j){
+        double point[Dim];
+        int indices[Dim];
+        double parametric_coord[Dim];
+        for (int i = 0; i < Dim; ++i){
+            point[i] = points(j, i);
+        }
+        bool inside = locate_point<Dim, Policy>(num_bins, range, point, indices,
+            parametric_coord);
+        double value = linear_interpolant(corners, parametric_coord,
+            corners.lower_corner(indices), values);
+        if constexpr (Policy == OutOfBounds::FILL){
+            value = inside ? value : fill_value;
+        }
+        interpolated_values(j) = value;
+        if (keep_intermediate){
+            for (int i = 0; i < Dim; ++i){
+                result.indices_pts(j, i) = indices[i];
+                result.parametric_coords(j, i) = parametric_coord[i];
+            }
+        }
+    });
+
+    if (keep_intermediate){
+        *intermediate = result;
+    }
+    return interpolated_values;
+}
+
+// cell of the sorted node coordinates coords[0, n) that holds x. The binary
+// search has a fixed number of steps without data dependent branches, and
+// points outside of the nodes fall into the first or last cell
+KOKKOS_INLINE_FUNCTION
+int find_cell(const double* coords, int n, double x){
+    int base = 0;
+    int len = n - 1;
+    while (len > 1){
+        int half = len / 2;
+        base = (coords[base + half] <= x) ? base + half : base;
+        len -= half;
+    }
+    return base;
+}
+
+// linear interpolation on a rectilinear grid of compile time dimension. The
+// node coordinates of each dimension are stored one dimension after the other
+// in grid_coords, so stretched grids are interpolated without resampling.
+// Points outside of the grid are handled by the Policy, with fill_value used
+// by OutOfBounds::FILL
+template <int Dim, OutOfBounds Policy = OutOfBounds::EXTRAPOLATE>
+RealVecView interpolate_rectilinear_grid(const RealMatView& points, const IntVecView& dimensions,
+    const RealVecView& grid_coords, const RealVecView& values, double fill_value = 0){
+    int N = points.extent(0);
+    const GridCorners<Dim> corners(dimensions);
+
+    RealVecView interpolated_values("approximated values", N);
+    Kokkos::parallel_for("rectilinear interpolation", N, KOKKOS_LAMBDA(int j){
+        int indices[Dim];
+        double parametric_coord[Dim];
+        int offset = 0;
+        bool inside = true;
+        for (int i = 0; i < Dim; ++i){
+            const double* coords = grid_coords.data() + offset;
+            int n = dimensions(i);
+            double x = points(j, i);
+            if constexpr (Policy == OutOfBounds::CLAMP){
+                x = std::fmin(std::fmax(x, coords[0]), coords[n - 1]);
+            }
+            if constexpr (Policy == OutOfBounds::FILL){
+                inside = inside && x >= coords[0] && x <= coords[n - 1];
+            }
+            // a single node dimension has a zero upper corner weight, and
+            // GridCorners gives its upper corner the offset of the lower one
+            int cell = n > 1 ? find_cell(coords, n, x) : 0;
+            indices[i] = cell;
+            parametric_coord[i] = n > 1 ? (x - coords[cell]) / (coords[cell + 1] - coords[cell]) : 0;
+            offset += n;
+        }
+        double value = linear_interpolant(corners, parametric_coord,
+            corners.lower_corner(indices), values);
+        if constexpr (Policy == OutOfBounds::FILL){
+            value = inside ? value : fill_value;
+        }
+        interpolated_values(j) = value;
+    });
+    return interpolated_values;
+}
+
 KOKKOS_INLINE_FUNCTION
 double test_function(double* coord){
     double fun_value = 0;
@@ -7,14 +7,27 @@
 #include <Omega_h_library.hpp>
 #include <Omega_h_mesh.hpp>
 #include <Omega_h_reduce.hpp>
-#define MAX_SIZE 500
+
+#include <cmath>
 using namespace std;
 using namespace Omega_h;
 
+// capacities of the BFS queue and visited set that the support search kernels
+// are compiled for. The smallest capacity that fits the expected number of
+// visited entities is used, and the next one if a search overflows
+static constexpr int bfs_capacity_small = 256;
+static constexpr int bfs_capacity_medium = 1024;
+static constexpr int bfs_capacity_large = 4096;
+
+// FIFO queue of entity ids for the BFS. Every entity is queued at most once, so
+// the queue is not a ring buffer. A push past the capacity marks the queue as
+// overflowed rather than overwriting queued ids
+template <int Capacity>
 class queue {
  private:
-  Real queue_array[MAX_SIZE];
-  int first = 0, last = -1, count = 0;
+  LO queue_array[Capacity];
+  int first = 0, last = 0;
+  bool overflow = false;
 
  public:
   OMEGA_H_INLINE
@@ -24,83 +37,151 @@ class queue {
   ~queue() {}
 
   OMEGA_H_INLINE
-  void push_back(const int& item);
+  void push_back(const LO& item);
 
   OMEGA_H_INLINE
   void pop_front();
 
   OMEGA_H_INLINE
-  int front();
+  LO front() const;
 
   OMEGA_H_INLINE
   bool isEmpty() const;
 
   OMEGA_H_INLINE
   bool isFull() const;
+
+  OMEGA_H_INLINE
+  bool overflowed() const;
 };
 
+// open addressing hash set of the visited entity ids with linear probing.
+// Insertion and lookup are O(1) on average. The set is kept at most half full
+// to keep the probe sequences short; an insertion beyond that marks the set as
+// overflowed
+template <int Capacity>
 class track {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "track capacity must be a power of two");
+
  private:
-  Real tracking_array[MAX_SIZE];
-  int first = 0, last = -1, count = 0;
+  static constexpr LO empty = -1;
+  LO tracking_array[Capacity];
+  int count = 0;
+  bool overflow = false;
 
  public:
   OMEGA_H_INLINE
-  track() {}
+  track() {
+    for (int i = 0; i < Capacity; ++i) {
+      tracking_array[i] = empty;
+    }
+  }
 
   OMEGA_H_INLINE
   ~track() {}
 
+  // marks the item as visited and returns true if it was not visited before
   OMEGA_H_INLINE
-  void push_back(const int& item);
+  bool insert(const LO& item);
 
   OMEGA_H_INLINE
-  int size();
+  int size() const;
 
   OMEGA_H_INLINE
-  bool notVisited(const int& item);
+  bool overflowed() const;
 };
 
-OMEGA_H_INLINE
-void queue::push_back(const int& item) {
-  last = (last + 1) % MAX_SIZE;
-  queue_array[last] = item;
-  count++;
+template <int Capacity>
+OMEGA_H_INLINE void queue<Capacity>::push_back(const LO& item) {
+  if (last == Capacity) {
+    overflow = true;
+    return;
+  }
+  queue_array[last++] = item;
 }
 
-OMEGA_H_INLINE
-void queue::pop_front() {
-  first = (first + 1) % MAX_SIZE;
-  count--;
+template <int Capacity>
+OMEGA_H_INLINE void queue<Capacity>::pop_front() {
+  first++;
 }
 
-OMEGA_H_INLINE
-int queue::front() { return queue_array[first]; }
+template <int Capacity>
+OMEGA_H_INLINE LO queue<Capacity>::front() const {
+  return queue_array[first];
+}
 
-OMEGA_H_INLINE
-bool queue::isEmpty() const { return count == 0; }
+template <int Capacity>
+OMEGA_H_INLINE bool queue<Capacity>::isEmpty() const {
+  return first == last;
+}
 
-OMEGA_H_INLINE
-bool queue::isFull() const { return count == MAX_SIZE; }
+template <int Capacity>
+OMEGA_H_INLINE bool queue<Capacity>::isFull() const {
+  return last == Capacity;
+}
 
-OMEGA_H_INLINE
-void track::push_back(const int& item) {
-  last = (last + 1) % MAX_SIZE;
-  tracking_array[last] = item;
-  count++;
+template <int Capacity>
+OMEGA_H_INLINE bool queue<Capacity>::overflowed() const {
+  return overflow;
 }
 
-OMEGA_H_INLINE
-bool track::notVisited(const int& item) {
-  for (int i = 0; i < count; ++i) {
-    if (tracking_array[i] == item) {
+template <int Capacity>
+OMEGA_H_INLINE bool track<Capacity>::insert(const LO& item) {
+  unsigned hash = static_cast<unsigned>(item) * 2654435761u;
+  hash ^= hash >> 16;
+  int slot = hash & (Capacity - 1);
+  while (tracking_array[slot] != empty) {
+    if (tracking_array[slot] == item) {
       return false;
     }
+    slot = (slot + 1) & (Capacity - 1);
   }
+  if (2 * (count + 1) > Capacity) {
+    overflow = true;
+    return false;
+  }
+  tracking_array[slot] = item;
+  count++;
   return true;
 }
 
-OMEGA_H_INLINE
-int track::size() { return count; }
+template <int Capacity>
+OMEGA_H_INLINE int track<Capacity>::size() const {
+  return count;
+}
+
+template <int Capacity>
+OMEGA_H_INLINE bool track<Capacity>::overflowed() const {
+  return overflow;
+}
+
+// estimate of the visited set capacity needed by a BFS that collects the
+// entities within the given squared radius. The visited entities cover the
+// disc of the radius grown by about one element on each side, and the visited
+// set must stay half empty
+inline int estimate_bfs_capacity(Real max_radius_sq, Real area_per_entity) {
+  Real element_size = std::sqrt(area_per_entity);
+  Real visited_radius = std::sqrt(max_radius_sq) + 2 * element_size;
+  Real nvisited = M_PI * visited_radius * visited_radius / area_per_entity;
+  return static_cast<int>(std::ceil(2 * nvisited));
+}
+
+// largest squared radius whose BFS is expected to fit in the visited set of
+// the given capacity. Inverse of estimate_bfs_capacity
+inline Real max_bfs_radius_sq(int capacity, Real area_per_entity) {
+  Real element_size = std::sqrt(area_per_entity);
+  Real visited_radius = std::sqrt(capacity * area_per_entity / (2 * M_PI));
+  Real radius = visited_radius - 2 * element_size;
+  return radius > 0 ? radius * radius : 0;
+}
+
+// estimate of the number of supports within the given squared radius with
+// some headroom for the variation of the element size. Used to size the
+// per-target candidate slots of the single pass search
+inline int estimate_support_count(Real max_radius_sq, Real area_per_entity) {
+  Real nsupports = M_PI * max_radius_sq / area_per_entity;
+  return static_cast<int>(std::ceil(1.5 * nsupports)) + 8;
+}
 
 #endif
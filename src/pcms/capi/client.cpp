@@ -7,6 +7,10 @@
 //   #include "pcms/omega_h_field.h"
 // #endif
 #include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "pcms/xgc_reverse_classification.h"
 #include "pcms/dummy_field_adapter.h"
 namespace pcms
@@ -37,6 +41,14 @@ void pcms_destroy_client(PcmsClientHandle* client)
   if (client != nullptr)
     delete reinterpret_cast<pcms::CouplerClient*>(client);
 }
+void pcms_enable_layout_cache(PcmsClientHandle* client_handle,
+                              const char* directory)
+{
+  auto* client = reinterpret_cast<pcms::CouplerClient*>(client_handle);
+  PCMS_ALWAYS_ASSERT(client != nullptr);
+  PCMS_ALWAYS_ASSERT(directory != nullptr);
+  client->EnableLayoutCache(directory);
+}
 PcmsReverseClassificationHandle* pcms_load_reverse_classification(
   const char* file, MPI_Comm comm)
 {
@@ -53,8 +65,12 @@ void pcms_destroy_reverse_classification(
 }
 
 struct AddFieldVariantOperators {
-  AddFieldVariantOperators(const char* name, pcms::CouplerClient* client, int participates)
-  : name_(name), client_(client), participates_(participates)
+  AddFieldVariantOperators(
+    const char* name, pcms::CouplerClient* client, int participates,
+    pcms::WireEncoding wire_encoding = pcms::WireEncoding::Native,
+    std::optional<double> delta_threshold = std::nullopt)
+  : name_(name), client_(client), participates_(participates),
+    wire_encoding_(wire_encoding), delta_threshold_(delta_threshold)
   {
   }
 
@@ -63,14 +79,30 @@ struct AddFieldVariantOperators {
   template <typename FieldAdapter>
   [[nodiscard]]
   pcms::CoupledField* operator()(const FieldAdapter& field_adapter) const noexcept {
-        return client_->AddField(name_, field_adapter, participates_);
+        return client_->AddField(name_, field_adapter, participates_,
+                                 wire_encoding_, delta_threshold_);
   }
 
   const char* name_;
   pcms::CouplerClient* client_;
   bool participates_;
+  pcms::WireEncoding wire_encoding_;
+  std::optional<double> delta_threshold_;
 };
 
+static pcms::WireEncoding to_wire_encoding(PcmsWireEncoding wire_encoding)
+{
+  switch (wire_encoding) {
+    case PCMS_WIRE_NATIVE: return pcms::WireEncoding::Native;
+    case PCMS_WIRE_FLOAT32: return pcms::WireEncoding::Float32;
+    case PCMS_WIRE_QUANTIZED16: return pcms::WireEncoding::Quantized16;
+    default:
+      printf("trying to add field with invalid wire encoding! %d",
+             wire_encoding);
+      std::abort();
+  }
+}
+
 PcmsFieldHandle* pcms_add_field(PcmsClientHandle* client_handle,
                                     const char* name,
                                     PcmsFieldAdapterHandle* adapter_handle,
@@ -92,6 +124,28 @@ PcmsFieldHandle* pcms_add_field(PcmsClientHandle* client_handle,
   pcms::CoupledField* field = std::visit(AddFieldVariantOperators{name, client, participates},*adapter);
   return reinterpret_cast<PcmsFieldHandle*>(field);
 }
+PcmsFieldHandle* pcms_add_field_ex(PcmsClientHandle* client_handle,
+                                   const char* name,
+                                   PcmsFieldAdapterHandle* adapter_handle,
+                                   int participates,
+                                   PcmsWireEncoding wire_encoding,
+                                   double delta_threshold)
+{
+  auto* adapter =
+    reinterpret_cast<pcms::FieldAdapterVariant*>(adapter_handle);
+  auto* client = reinterpret_cast<pcms::CouplerClient*>(client_handle);
+  PCMS_ALWAYS_ASSERT(client != nullptr);
+  PCMS_ALWAYS_ASSERT(adapter != nullptr);
+  std::optional<double> threshold;
+  if (delta_threshold >= 0) {
+    threshold = delta_threshold;
+  }
+  pcms::CoupledField* field = std::visit(
+    AddFieldVariantOperators{name, client, participates,
+                             to_wire_encoding(wire_encoding), threshold},
+    *adapter);
+  return reinterpret_cast<PcmsFieldHandle*>(field);
+}
 void pcms_send_field_name(PcmsClientHandle* client_handle, const char* name)
 {
   auto* client = reinterpret_cast<pcms::CouplerClient*>(client_handle);
@@ -117,6 +171,57 @@ void pcms_receive_field(PcmsFieldHandle* field_handle)
   PCMS_ALWAYS_ASSERT(field != nullptr);
   field->Receive();
 }
+PcmsFieldGroupHandle* pcms_add_field_group(PcmsClientHandle* client_handle,
+                                           const char* name,
+                                           const char* field_names,
+                                           PcmsType data_type)
+{
+  auto* client = reinterpret_cast<pcms::CouplerClient*>(client_handle);
+  PCMS_ALWAYS_ASSERT(client != nullptr);
+  PCMS_ALWAYS_ASSERT(field_names != nullptr);
+  std::vector<std::string> names;
+  std::istringstream names_stream(field_names);
+  for (std::string field_name; std::getline(names_stream, field_name, ',');) {
+    // allow whitespace around the names since fortran strings are padded
+    const auto first = field_name.find_first_not_of(" \t");
+    const auto last = field_name.find_last_not_of(" \t");
+    if (first != std::string::npos) {
+      names.push_back(field_name.substr(first, last - first + 1));
+    }
+  }
+  PCMS_ALWAYS_ASSERT(!names.empty());
+  pcms::FieldGroup* group = nullptr;
+  switch (data_type) {
+    case PCMS_DOUBLE:
+      group = client->AddFieldGroup<double>(name, names);
+      break;
+    case PCMS_FLOAT:
+      group = client->AddFieldGroup<float>(name, names);
+      break;
+    case PCMS_INT:
+      group = client->AddFieldGroup<int>(name, names);
+      break;
+    case PCMS_LONG_INT:
+      group = client->AddFieldGroup<long int>(name, names);
+      break;
+    default:
+      printf("trying to add field group with invalid type! %d", data_type);
+      std::abort();
+  }
+  return reinterpret_cast<PcmsFieldGroupHandle*>(group);
+}
+void pcms_send_field_group(PcmsFieldGroupHandle* group_handle)
+{
+  auto* group = reinterpret_cast<pcms::FieldGroup*>(group_handle);
+  PCMS_ALWAYS_ASSERT(group != nullptr);
+  group->Send();
+}
+void pcms_receive_field_group(PcmsFieldGroupHandle* group_handle)
+{
+  auto* group = reinterpret_cast<pcms::FieldGroup*>(group_handle);
+  PCMS_ALWAYS_ASSERT(group != nullptr);
+  group->Receive();
+}
 template <typename T>
 void pcms_create_xgc_field_adapter_t(
   const char* name, MPI_Comm comm, void* data, int size,
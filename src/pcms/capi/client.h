@@ -16,6 +16,8 @@ struct PcmsFieldAdapterHandle;
 typedef struct PcmsFieldAdapterHandle PcmsFieldAdapterHandle;
 struct PcmsFieldHandle;
 typedef struct PcmsFieldHandle PcmsFieldHandle;
+struct PcmsFieldGroupHandle;
+typedef struct PcmsFieldGroupHandle PcmsFieldGroupHandle;
 
 enum PcmsAdapterType
 {
@@ -33,9 +35,20 @@ enum PcmsType
   PCMS_LONG_INT
 };
 typedef enum PcmsType PcmsType;
+enum PcmsWireEncoding
+{
+  PCMS_WIRE_NATIVE,
+  PCMS_WIRE_FLOAT32,
+  PCMS_WIRE_QUANTIZED16
+};
+typedef enum PcmsWireEncoding PcmsWireEncoding;
 
 PcmsClientHandle* pcms_create_client(const char* name, MPI_Comm comm);
 void pcms_destroy_client(PcmsClientHandle*);
+// fields added after this call validate their message layouts against the
+// layouts the server cached in a previous run. The server must enable the
+// layout cache as well
+void pcms_enable_layout_cache(PcmsClientHandle*, const char* directory);
 
 // returns a pointer to a handle to a reverse classification object
 PcmsReverseClassificationHandle* pcms_load_reverse_classification(
@@ -63,12 +76,32 @@ PcmsFieldHandle* pcms_add_field(PcmsClientHandle* client_handle,
                                     const char* name,
                                     PcmsFieldAdapterHandle* adapter_handle,
                                     int participates);
+// same as pcms_add_field, but selects how the values are encoded in the
+// messages. With a delta_threshold >= 0 the field is only sent when it changed
+// by more than the threshold, a negative delta_threshold always sends it. The
+// server must add the field with the same options
+PcmsFieldHandle* pcms_add_field_ex(PcmsClientHandle* client_handle,
+                                   const char* name,
+                                   PcmsFieldAdapterHandle* adapter_handle,
+                                   int participates,
+                                   PcmsWireEncoding wire_encoding,
+                                   double delta_threshold);
 void pcms_send_field_name(PcmsClientHandle*, const char* name);
 void pcms_receive_field_name(PcmsClientHandle*, const char* name);
 
 void pcms_send_field(PcmsFieldHandle*);
 void pcms_receive_field(PcmsFieldHandle*);
 
+// field_names is a comma separated list of fields that were already added to
+// the client. The fields are sent as one message per destination rank, so
+// they must have the same partition and data_type
+PcmsFieldGroupHandle* pcms_add_field_group(PcmsClientHandle* client_handle,
+                                           const char* name,
+                                           const char* field_names,
+                                           PcmsType data_type);
+void pcms_send_field_group(PcmsFieldGroupHandle*);
+void pcms_receive_field_group(PcmsFieldGroupHandle*);
+
 void pcms_begin_send_phase(PcmsClientHandle*);
 void pcms_end_send_phase(PcmsClientHandle*);
 void pcms_begin_receive_phase(PcmsClientHandle*);
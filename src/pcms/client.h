@@ -3,6 +3,8 @@
 #include "pcms/common.h"
 #include "pcms/field_communicator.h"
 #include "pcms/profile.h"
+#include <any>
+#include <functional>
 namespace pcms
 {
 
@@ -12,7 +14,11 @@ public:
   template <typename FieldAdapterT>
   CoupledField(const std::string& name, FieldAdapterT field_adapter,
                MPI_Comm mpi_comm, redev::Redev& redev, redev::Channel& channel,
-               bool participates)
+               bool participates, std::string layout_cache_directory = "",
+               std::shared_ptr<detail::MessageLayoutRegistry> layout_registry =
+                 nullptr,
+               WireEncoding wire_encoding = WireEncoding::Native,
+               std::optional<double> delta_threshold = std::nullopt)
   {
     PCMS_FUNCTION_TIMER;
     MPI_Comm mpi_comm_subset = MPI_COMM_NULL;
@@ -27,7 +33,8 @@ public:
     coupled_field_ =
       std::make_unique<CoupledFieldModel<FieldAdapterT, FieldAdapterT>>(
         name, std::move(field_adapter), mpi_comm_subset, redev, channel,
-        participates);
+        participates, std::move(layout_cache_directory),
+        std::move(layout_registry), wire_encoding, delta_threshold);
   }
 
   void Send(Mode mode = Mode::Synchronous)
@@ -35,15 +42,37 @@ public:
     PCMS_FUNCTION_TIMER;
     coupled_field_->Send(mode);
   }
-  void Receive()
+  void Receive(Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
-    coupled_field_->Receive();
+    coupled_field_->Receive(mode);
+  }
+  // deserialize the field after a deferred receive once the receive phase
+  // ended
+  void FinishReceive()
+  {
+    PCMS_FUNCTION_TIMER;
+    coupled_field_->FinishReceive();
+  }
+  template <typename T>
+  [[nodiscard]] detail::MessagePacker<T>* GetMessagePacker()
+  {
+    PCMS_FUNCTION_TIMER;
+    auto packer = coupled_field_->GetMessagePacker();
+    if (auto* p = std::any_cast<detail::MessagePacker<T>*>(&packer)) {
+      return *p;
+    }
+    std::cerr << "Requested type does not match field value type\n";
+    std::abort();
   }
   struct CoupledFieldConcept
   {
     virtual void Send(Mode) = 0;
-    virtual void Receive() = 0;
+    virtual void Receive(Mode) = 0;
+    virtual void FinishReceive() = 0;
+    // message packer of the field communicator, or empty if the field is not
+    // communicated
+    [[nodiscard]] virtual std::any GetMessagePacker() noexcept = 0;
     virtual ~CoupledFieldConcept() = default;
   };
   template <typename FieldAdapterT, typename CommT>
@@ -53,11 +82,19 @@ public:
 
     CoupledFieldModel(const std::string& name, FieldAdapterT&& field_adapter,
                       MPI_Comm mpi_comm_subset, redev::Redev& redev,
-                      redev::Channel& channel, bool participates)
+                      redev::Channel& channel, bool participates,
+                      std::string layout_cache_directory,
+                      std::shared_ptr<detail::MessageLayoutRegistry>
+                        layout_registry,
+                      WireEncoding wire_encoding,
+                      std::optional<double> delta_threshold)
       : mpi_comm_subset_(mpi_comm_subset),
         field_adapter_(std::move(field_adapter)),
         comm_(FieldCommunicator<CommT>(name, mpi_comm_subset_, redev, channel,
-                                       field_adapter_))
+                                       field_adapter_,
+                                       std::move(layout_cache_directory),
+                                       std::move(layout_registry),
+                                       wire_encoding, delta_threshold))
     {
       PCMS_FUNCTION_TIMER;
     }
@@ -66,11 +103,25 @@ public:
       PCMS_FUNCTION_TIMER;
       comm_.Send(mode);
     };
-    void Receive() final
+    void Receive(Mode mode) final
+    {
+      PCMS_FUNCTION_TIMER;
+      comm_.Receive(mode);
+    };
+    void FinishReceive() final
     {
       PCMS_FUNCTION_TIMER;
-      comm_.Receive();
+      comm_.FinishReceive();
     };
+    std::any GetMessagePacker() noexcept final
+    {
+      using Packer = detail::MessagePacker<value_type>;
+      if constexpr (std::is_base_of_v<Packer, FieldCommunicator<CommT>>) {
+        return static_cast<Packer*>(&comm_);
+      } else {
+        return {};
+      }
+    }
     ~CoupledFieldModel()
     {
       PCMS_FUNCTION_TIMER;
@@ -109,14 +160,28 @@ public:
     return redev_.GetPartition();
   }
 
+  // fields added after this call validate their message layouts against the
+  // layouts the server cached in a previous run rather than exchanging all
+  // gids. The server application must enable the layout cache as well
+  void EnableLayoutCache(std::string directory)
+  {
+    layout_cache_directory_ = std::move(directory);
+  }
+
+  // wire_encoding selects how the values are encoded in the messages. With a
+  // delta_threshold the field is only sent when it changed by more than the
+  // threshold. The server must add the field with the same options
   template <typename FieldAdapterT>
   CoupledField* AddField(std::string name, FieldAdapterT field_adapter,
-                         bool participates = true)
+                         bool participates = true,
+                         WireEncoding wire_encoding = WireEncoding::Native,
+                         std::optional<double> delta_threshold = std::nullopt)
   {
     PCMS_FUNCTION_TIMER;
-    auto [it, inserted] =
-      fields_.template try_emplace(name, name, std::move(field_adapter),
-                                   mpi_comm_, redev_, channel_, participates);
+    auto [it, inserted] = fields_.template try_emplace(
+      name, name, std::move(field_adapter), mpi_comm_, redev_, channel_,
+      participates, layout_cache_directory_, layout_registry_, wire_encoding,
+      delta_threshold);
     if (!inserted) {
       std::cerr << "OHField with this name" << name << "already exists!\n";
       std::terminate();
@@ -134,11 +199,55 @@ public:
   };
   // take a string& since map cannot be searched with string_view
   // (heterogeneous lookup)
-  void ReceiveField(const std::string& name)
+  // with Mode::Deferred the field is deserialized when the receive phase
+  // ends, so several fields can be received before any of them is processed
+  void ReceiveField(const std::string& name, Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(InReceivePhase());
+    auto& field = detail::find_or_error(name, fields_);
+    field.Receive(mode);
+    if (mode == Mode::Deferred) {
+      deferred_receives_.emplace_back([&field]() { field.FinishReceive(); });
+    }
+  };
+  // fields in a group are sent and received as one message per destination
+  // rank, so all of them must have the same partition and value type
+  template <typename T = Real>
+  FieldGroup* AddFieldGroup(const std::string& name,
+                            const std::vector<std::string>& field_names)
+  {
+    PCMS_FUNCTION_TIMER;
+    std::vector<detail::MessagePacker<T>*> packers;
+    packers.reserve(field_names.size());
+    for (const auto& field_name : field_names) {
+      auto& field = detail::find_or_error(field_name, fields_);
+      packers.push_back(field.template GetMessagePacker<T>());
+    }
+    auto [it, inserted] = field_groups_.try_emplace(
+      name, std::in_place_type<T>, name, channel_, std::move(packers));
+    if (!inserted) {
+      std::cerr << "FieldGroup with this name" << name << "already exists!\n";
+      std::terminate();
+    }
+    return &(it->second);
+  }
+  void SendFieldGroup(const std::string& name, Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(InSendPhase());
+    detail::find_or_error(name, field_groups_).Send(mode);
+  };
+  void ReceiveFieldGroup(const std::string& name,
+                         Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
     PCMS_ALWAYS_ASSERT(InReceivePhase());
-    detail::find_or_error(name, fields_).Receive();
+    auto& group = detail::find_or_error(name, field_groups_);
+    group.Receive(mode);
+    if (mode == Mode::Deferred) {
+      deferred_receives_.emplace_back([&group]() { group.FinishReceive(); });
+    }
   };
   [[nodiscard]] bool InSendPhase() const noexcept
   {
@@ -169,15 +278,34 @@ public:
   {
     PCMS_FUNCTION_TIMER;
     channel_.EndReceiveCommunicationPhase();
+    FinishDeferredReceives();
   }
 
 private:
+  void FinishDeferredReceives()
+  {
+    PCMS_FUNCTION_TIMER;
+    for (auto& finish_receive : deferred_receives_) {
+      finish_receive();
+    }
+    deferred_receives_.clear();
+  }
+
   std::string name_;
   MPI_Comm mpi_comm_;
   redev::Redev redev_;
+  std::string layout_cache_directory_;
+  // layouts shared by the fields with the same gids and partition
+  std::shared_ptr<detail::MessageLayoutRegistry> layout_registry_ =
+    std::make_shared<detail::MessageLayoutRegistry>();
   // map rather than unordered_map is necessary to avoid iterator invalidation.
   // This is important because we pass pointers to the fields out of this class
   std::map<std::string, CoupledField> fields_;
+  // field groups refer to the fields, so they are declared after them to be
+  // destroyed first
+  std::map<std::string, FieldGroup> field_groups_;
+  // deserialization of the fields received with Mode::Deferred
+  std::vector<std::function<void()>> deferred_receives_;
   redev::Channel channel_;
 };
 } // namespace pcms
@@ -1,25 +1,28 @@
 #ifndef PCMS_COUPLING_FIELD_COMMUNICATOR_H
 #define PCMS_COUPLING_FIELD_COMMUNICATOR_H
 #include <redev.h>
+#include <Kokkos_Core.hpp>
+#include <Kokkos_UnorderedMap.hpp>
 #include "pcms/field.h"
+#include <algorithm>
+#include <cmath>
 #include <numeric>
+#include <memory>
+#include <optional>
 #include "pcms/inclusive_scan.h"
+#include "pcms/layout_cache.h"
+#include "pcms/message_layout.h"
 #include "pcms/profile.h"
+#include "pcms/wire_encoding.h"
 namespace pcms
 {
 
 namespace detail
 {
-struct OutMsg
-{
-  redev::LOs dest;
-  redev::LOs offset;
-};
-
 // reverse partition is a map that has the partition rank as a key
 // and the values are an vector where each entry is the index into
 // the array of data to send
-OutMsg ConstructOutMessage(const ReversePartitionMap& reverse_partition)
+inline OutMsg ConstructOutMessage(const ReversePartitionMap& reverse_partition)
 {
   PCMS_FUNCTION_TIMER;
   OutMsg out;
@@ -38,7 +41,7 @@ OutMsg ConstructOutMessage(const ReversePartitionMap& reverse_partition)
                          std::next(out.offset.begin(), 1));
   return out;
 }
-size_t count_entries(const ReversePartitionMap& reverse_partition)
+inline size_t count_entries(const ReversePartitionMap& reverse_partition)
 {
   PCMS_FUNCTION_TIMER;
   size_t num_entries = 0;
@@ -48,7 +51,8 @@ size_t count_entries(const ReversePartitionMap& reverse_partition)
   return num_entries;
 }
 // note this function can be parallelized by making use of the offsets
-redev::LOs ConstructPermutation(const ReversePartitionMap& reverse_partition)
+inline redev::LOs ConstructPermutation(
+  const ReversePartitionMap& reverse_partition)
 {
   PCMS_FUNCTION_TIMER;
   auto num_entries = count_entries(reverse_partition);
@@ -68,26 +72,73 @@ redev::LOs ConstructPermutation(const ReversePartitionMap& reverse_partition)
  * @param received_gids received GIDs are the GIDS in the order of the incomming
  * message1
  * @return permutation array such that GIDS(Permutation[i]) = msgs
+ *
+ * The permutation is a hash join of the received gids with the local gids in
+ * the host execution space. Duplicate gids on either side and received gids
+ * that are not local are found in the same pass, so this also checks that the
+ * received gids are a permutation of the local gids.
  */
-redev::LOs ConstructPermutation(const std::vector<pcms::GO>& local_gids,
-                                const std::vector<pcms::GO>& received_gids)
+inline redev::LOs ConstructPermutation(
+  const std::vector<pcms::GO>& local_gids,
+  const std::vector<pcms::GO>& received_gids)
 {
   PCMS_FUNCTION_TIMER;
+  using ExecutionSpace = Kokkos::DefaultHostExecutionSpace;
   REDEV_ALWAYS_ASSERT(local_gids.size() == received_gids.size());
-  REDEV_ALWAYS_ASSERT(std::is_permutation(local_gids.begin(), local_gids.end(), received_gids.begin()));
-  std::map<pcms::GO, pcms::LO> global_to_local_ids;
-  for (size_t i = 0; i < local_gids.size(); ++i) {
-    global_to_local_ids[local_gids[i]] = i;
-  }
-  redev::LOs permutation;
-  permutation.reserve(local_gids.size());
-  for (auto gid : received_gids) {
-    permutation.push_back(global_to_local_ids[gid]);
-  }
+  const auto n = static_cast<LO>(local_gids.size());
+  const auto* local = local_gids.data();
+  const auto* received = received_gids.data();
+
+  Kokkos::UnorderedMap<GO, LO, ExecutionSpace> global_to_local_ids(n);
+  // counts of the inserts that found an existing key and of the inserts that
+  // failed because the map ran out of capacity
+  Kokkos::View<LO[2], Kokkos::HostSpace> insert_errors("insert errors");
+  Kokkos::parallel_for(
+    "insert local gids", Kokkos::RangePolicy<ExecutionSpace>(0, n),
+    [=](LO i) {
+      const auto result = global_to_local_ids.insert(local[i], i);
+      if (result.failed()) {
+        Kokkos::atomic_increment(&insert_errors(1));
+      } else if (result.existing()) {
+        Kokkos::atomic_increment(&insert_errors(0));
+      }
+    });
+  ExecutionSpace().fence();
+  // an existing key is a duplicate local gid
+  const LO duplicate_local_gids = insert_errors(0);
+  REDEV_ALWAYS_ASSERT(duplicate_local_gids == 0);
+  // the map is sized for all local gids, so running out of capacity is a
+  // bug rather than bad input
+  const LO failed_inserts = insert_errors(1);
+  REDEV_ALWAYS_ASSERT(failed_inserts == 0);
+
+  redev::LOs permutation(n);
+  auto* perm = permutation.data();
+  Kokkos::View<int*, Kokkos::HostSpace> claimed("claimed local ids", n);
+  LO mismatches = 0;
+  Kokkos::parallel_reduce(
+    "join received gids", Kokkos::RangePolicy<ExecutionSpace>(0, n),
+    [=](LO i, LO& mismatch) {
+      const auto index = global_to_local_ids.find(received[i]);
+      if (!global_to_local_ids.valid_at(index)) {
+        ++mismatch;
+        return;
+      }
+      const LO local_id = global_to_local_ids.value_at(index);
+      // a local id that is claimed twice is a duplicate received gid
+      if (Kokkos::atomic_exchange(&claimed(local_id), 1) != 0) {
+        ++mismatch;
+      }
+      perm[i] = local_id;
+    },
+    mismatches);
+  // Duplicate data indicates that sender is not sending data from only the
+  // owned rank
+  REDEV_ALWAYS_ASSERT(mismatches == 0);
   return permutation;
 }
-OutMsg ConstructOutMessage(int rank, int nproc,
-                           const redev::InMessageLayout& in)
+inline OutMsg ConstructOutMessage(int rank, int nproc,
+                                  const redev::InMessageLayout& in)
 {
   PCMS_FUNCTION_TIMER;
   REDEV_ALWAYS_ASSERT(!in.srcRanks.empty());
@@ -120,14 +171,128 @@ OutMsg ConstructOutMessage(int rank, int nproc,
   return out;
 }
 
+// The gid message to each rank is sent as a header with the number of gids
+// and the number of ranges, followed by the (first gid, length) pair of each
+// range of consecutive gids. When the gids are too scattered for the ranges
+// to be shorter, the number of ranges is raw_gids and the gids follow as is
+constexpr GO raw_gids = -1;
+
+struct EncodedGids
+{
+  // offsets of the encoded message of each rank
+  redev::LOs offset;
+  std::vector<GO> data;
+};
+
+// range encoding of gid_msgs, which are split between the ranks by layout
+inline EncodedGids EncodeGidMessages(const OutMsg& layout,
+                                     const std::vector<GO>& gid_msgs)
+{
+  PCMS_FUNCTION_TIMER;
+  EncodedGids encoded;
+  encoded.offset.reserve(layout.offset.size());
+  encoded.offset.push_back(0);
+  for (size_t r = 0; r + 1 < layout.offset.size(); ++r) {
+    const GO* gids = gid_msgs.data() + layout.offset[r];
+    const GO n = layout.offset[r + 1] - layout.offset[r];
+    GO nranges = n > 0 ? 1 : 0;
+    for (GO i = 1; i < n; ++i) {
+      nranges += gids[i] != gids[i - 1] + 1;
+    }
+    const bool use_ranges = 2 * nranges < n;
+    encoded.data.push_back(n);
+    encoded.data.push_back(use_ranges ? nranges : raw_gids);
+    if (use_ranges) {
+      GO first = 0;
+      for (GO i = 0; i < n; ++i) {
+        if (i + 1 == n || gids[i + 1] != gids[i] + 1) {
+          encoded.data.push_back(gids[first]);
+          encoded.data.push_back(i + 1 - first);
+          first = i + 1;
+        }
+      }
+    } else {
+      encoded.data.insert(encoded.data.end(), gids, gids + n);
+    }
+    encoded.offset.push_back(encoded.data.size());
+  }
+  return encoded;
+}
+
+// decodes the messages received from the ranks given by layout, which has
+// the offsets of the encoded messages. Returns the layout of the decoded
+// gids along with the gids
+inline std::pair<OutMsg, std::vector<GO>> DecodeGidMessages(
+  const OutMsg& layout, const std::vector<GO>& data)
+{
+  PCMS_FUNCTION_TIMER;
+  OutMsg decoded_layout;
+  decoded_layout.dest = layout.dest;
+  decoded_layout.offset.reserve(layout.offset.size());
+  decoded_layout.offset.push_back(0);
+  std::vector<GO> gids;
+  for (size_t r = 0; r + 1 < layout.offset.size(); ++r) {
+    const GO* message = data.data() + layout.offset[r];
+    const GO length = layout.offset[r + 1] - layout.offset[r];
+    REDEV_ALWAYS_ASSERT(length >= 2);
+    const GO n = message[0];
+    const GO nranges = message[1];
+    if (nranges == raw_gids) {
+      REDEV_ALWAYS_ASSERT(length == 2 + n);
+      gids.insert(gids.end(), message + 2, message + 2 + n);
+    } else {
+      REDEV_ALWAYS_ASSERT(length == 2 + 2 * nranges);
+      const auto begin = gids.size();
+      for (GO i = 0; i < nranges; ++i) {
+        const GO first = message[2 + 2 * i];
+        const GO range_length = message[3 + 2 * i];
+        for (GO gid = first; gid < first + range_length; ++gid) {
+          gids.push_back(gid);
+        }
+      }
+      REDEV_ALWAYS_ASSERT(gids.size() - begin == static_cast<size_t>(n));
+    }
+    decoded_layout.offset.push_back(gids.size());
+  }
+  return {std::move(decoded_layout), std::move(gids)};
+}
+
+// true if any value differs from the snapshot by more than threshold. NaN
+// values always count as changed
 template <typename T>
-bool HasDuplicates(std::vector<T> v)
+bool MessageChanged(const std::vector<T>& values,
+                    const std::vector<T>& snapshot, double threshold)
 {
   PCMS_FUNCTION_TIMER;
-  std::sort(v.begin(), v.end());
-  auto it = std::adjacent_find(v.begin(), v.end());
-  return it != v.end();
+  REDEV_ALWAYS_ASSERT(values.size() == snapshot.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    const double difference = std::abs(static_cast<double>(values[i]) -
+                                       static_cast<double>(snapshot[i]));
+    if (!(difference <= threshold)) {
+      return true;
+    }
+  }
+  return false;
 }
+
+// interface to pack a field into its messages so several fields with the same
+// message layout can share a single message per destination rank
+template <typename T>
+struct MessagePacker
+{
+  // destination ranks and offsets of the messages of the field. The same
+  // layout is used for the data that is sent and received
+  [[nodiscard]] virtual const OutMsg& GetMessageLayout() const noexcept = 0;
+  [[nodiscard]] virtual MPI_Comm GetMPIComm() const noexcept = 0;
+  // serialize the field in message order into buffer, which must hold the
+  // full message of the field
+  virtual void SerializeMessage(
+    ScalarArrayView<T, HostMemorySpace> buffer) = 0;
+  // deserialize the field from buffer in message order
+  virtual void DeserializeMessage(
+    ScalarArrayView<const T, HostMemorySpace> buffer) = 0;
+  virtual ~MessagePacker() = default;
+};
 } // namespace detail
 
 using redev::Mode;
@@ -135,25 +300,66 @@ using redev::Mode;
 // TODO refactor to take application rather than channel
 template <typename FieldAdapterT>
 struct FieldCommunicator
+  : public detail::MessagePacker<typename FieldAdapterT::value_type>
 {
   using T = typename FieldAdapterT::value_type;
 
 public:
-  FieldCommunicator(std::string name, MPI_Comm mpi_comm, redev::Redev& redev,
-                    redev::Channel& channel,
-                    FieldAdapterT& field_adapter)
+  // if layout_cache_directory is not empty the message layout is validated
+  // against the layout cached by the server in that directory rather than
+  // rebuilt from the gids. The client only takes part in the handshake and
+  // does not write any files, but it must enable the cache whenever the
+  // server does. Fields that are given the same layout_registry share their
+  // layout when their gids and partitions are the same. Both sides of the
+  // channel must use the same wire_encoding for a field.
+  // With a delta_threshold the field is only sent when some value changed by
+  // more than the threshold since it was last sent, and the receiver keeps
+  // its values otherwise. A threshold of zero sends any change. Both sides
+  // must enable delta transfers for the field
+  FieldCommunicator(
+    std::string name, MPI_Comm mpi_comm, redev::Redev& redev,
+    redev::Channel& channel, FieldAdapterT& field_adapter,
+    std::string layout_cache_directory = "",
+    std::shared_ptr<detail::MessageLayoutRegistry> layout_registry = nullptr,
+    WireEncoding wire_encoding = WireEncoding::Native,
+    std::optional<double> delta_threshold = std::nullopt)
     : mpi_comm_(mpi_comm),
       channel_(channel),
       comm_buffer_{},
-      message_permutation_{},
+      layout_{std::make_shared<const detail::MessageLayout>()},
+      layout_registry_(std::move(layout_registry)),
       buffer_size_needs_update_{true},
       field_adapter_(field_adapter),
       name_{std::move(name)},
-      redev_(redev)
+      redev_(redev),
+      layout_cache_directory_(std::move(layout_cache_directory)),
+      wire_encoding_(wire_encoding),
+      delta_threshold_(delta_threshold)
   {
     PCMS_FUNCTION_TIMER;
-    comm_ = channel.CreateComm<T>(name_, mpi_comm_);
+    // reduced precision encodings only make sense for floating point fields
+    PCMS_ALWAYS_ASSERT(wire_encoding_ == WireEncoding::Native ||
+                       std::is_floating_point_v<T>);
+    switch (wire_encoding_) {
+      case WireEncoding::Native:
+        comm_ = channel.CreateComm<T>(name_, mpi_comm_);
+        break;
+      case WireEncoding::Float32:
+        float_comm_ = channel.CreateComm<float>(name_, mpi_comm_);
+        break;
+      case WireEncoding::Quantized16:
+        quantized_comm_ =
+          channel.CreateComm<detail::QuantizedValue>(name_, mpi_comm_);
+        break;
+    }
     gid_comm_ = channel.CreateComm<GO>(name_ + "_gids", mpi_comm_);
+    if (delta_threshold_) {
+      PCMS_ALWAYS_ASSERT(*delta_threshold_ >= 0);
+      delta_comm_ = channel.CreateComm<GO>(name_ + "_delta", mpi_comm_);
+    }
+    if (UseLayoutCache()) {
+      layout_comm_ = channel.CreateComm<GO>(name_ + "_layout", mpi_comm_);
+    }
     if(mpi_comm != MPI_COMM_NULL) {
       UpdateLayout();
     }
@@ -167,27 +373,90 @@ public:
   FieldCommunicator& operator=(const FieldCommunicator&) = delete;
   FieldCommunicator& operator=(FieldCommunicator&&) = default;
 
+  // the message size is fixed by UpdateLayout, so the field is serialized
+  // straight into the send buffer once the size query of the adapter agrees
+  // with it. The buffer outlives the send, so with Mode::Deferred the channel
+  // reads it at the end of the communication phase without copying it first
   void Send(Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
     PCMS_ALWAYS_ASSERT(channel_.InSendCommunicationPhase());
-    auto n = field_adapter_.Serialize({}, {});
-    REDEV_ALWAYS_ASSERT(comm_buffer_.size() == static_cast<size_t>(n));
     auto buffer = make_array_view(comm_buffer_);
-    field_adapter_.Serialize(buffer,
-                             make_const_array_view(message_permutation_));
-    comm_.Send(buffer.data_handle(), mode);
+    SerializeMessage(buffer);
+    if (delta_threshold_ && !SendDeltaHeader(mode)) {
+      return;
+    }
+    switch (wire_encoding_) {
+      case WireEncoding::Native: comm_.Send(buffer.data_handle(), mode); break;
+      case WireEncoding::Float32:
+        float_buffer_.assign(comm_buffer_.begin(), comm_buffer_.end());
+        float_comm_.Send(float_buffer_.data(), mode);
+        break;
+      case WireEncoding::Quantized16:
+        detail::QuantizeMessages(layout_->out_message, comm_buffer_.data(),
+                                 quantized_buffer_);
+        quantized_comm_.Send(quantized_buffer_.data(), mode);
+        break;
+    }
   }
-  void Receive()
+  // with Mode::Deferred the received data is only filled in when the receive
+  // phase ends, so the field is deserialized by FinishReceive after the phase
+  // rather than here
+  void Receive(Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
     PCMS_ALWAYS_ASSERT(channel_.InReceiveCommunicationPhase());
-    // Current implementation requires that Receive is always called in Sync
-    // mode because we make an immediate call to deserialize after a call to
-    // receive.
-    auto data = comm_.Recv(Mode::Synchronous);
-    field_adapter_.Deserialize(make_const_array_view(data),
-                               make_const_array_view(message_permutation_));
+    PCMS_ALWAYS_ASSERT(!receive_pending_);
+    // an unchanged field is not sent and keeps its current values
+    if (delta_threshold_ && !ReceiveDeltaHeader()) {
+      return;
+    }
+    switch (wire_encoding_) {
+      case WireEncoding::Native: recv_buffer_ = comm_.Recv(mode); break;
+      case WireEncoding::Float32:
+        float_recv_buffer_ = float_comm_.Recv(mode);
+        break;
+      case WireEncoding::Quantized16:
+        quantized_recv_buffer_ = quantized_comm_.Recv(mode);
+        break;
+    }
+    receive_pending_ = true;
+    if (mode == Mode::Synchronous) {
+      DeserializeReceived();
+    }
+  }
+  // deserialize the data of a deferred receive once the receive phase ended.
+  // Does nothing if there is no pending receive
+  void FinishReceive()
+  {
+    PCMS_FUNCTION_TIMER;
+    if (receive_pending_) {
+      PCMS_ALWAYS_ASSERT(!channel_.InReceiveCommunicationPhase());
+      DeserializeReceived();
+    }
+  }
+  [[nodiscard]] const detail::OutMsg& GetMessageLayout() const noexcept final
+  {
+    return layout_->out_message;
+  }
+  [[nodiscard]] MPI_Comm GetMPIComm() const noexcept final { return mpi_comm_; }
+  void SerializeMessage(ScalarArrayView<T, HostMemorySpace> buffer) final
+  {
+    PCMS_FUNCTION_TIMER;
+    // the message size is fixed by UpdateLayout, so the field is copied once
+    // and the size it reports is checked against the layout afterwards
+    REDEV_ALWAYS_ASSERT(buffer.size() == message_size_);
+    const auto n = field_adapter_.Serialize(
+      buffer, make_const_array_view(layout_->permutation));
+    REDEV_ALWAYS_ASSERT(static_cast<size_t>(n) == message_size_);
+  }
+  void DeserializeMessage(
+    ScalarArrayView<const T, HostMemorySpace> buffer) final
+  {
+    PCMS_FUNCTION_TIMER;
+    REDEV_ALWAYS_ASSERT(buffer.size() == message_size_);
+    field_adapter_.Deserialize(buffer,
+                               make_const_array_view(layout_->permutation));
   }
   /** update the permutation array and buffer sizes upon mesh change
    * @WARNING this function mut be called on *both* the client and server
@@ -196,6 +465,14 @@ public:
 private:
   // note channel_ operations are collective on full channel comm
   // comm_ operations should only be called on ranks with
+  //
+  // When the layout cache is enabled the layout exchange starts with a
+  // handshake. Each client rank sends every server rank it communicates with
+  // a hash of the gids it would send. If every server rank finds the same
+  // hashes in its cached layout, the cached layout and permutation are used
+  // and the gids are not sent. Otherwise the full exchange runs and the server
+  // updates its cache. The gid phase happens either way so that all ranks of
+  // the channel take part in the same phases
   void UpdateLayout()
   {
     PCMS_FUNCTION_TIMER;
@@ -204,49 +481,246 @@ private:
       if (redev_.GetProcessType() == redev::ProcessType::Client) {
         const ReversePartitionMap reverse_partition =
           field_adapter_.GetReversePartitionMap(redev_.GetPartition());
-        auto out_message = detail::ConstructOutMessage(reverse_partition);
-        comm_.SetOutMessageLayout(out_message.dest, out_message.offset);
-        gid_comm_.SetOutMessageLayout(out_message.dest, out_message.offset);
-        message_permutation_ = detail::ConstructPermutation(reverse_partition);
+        detail::MessageLayout layout;
+        layout.out_message = detail::ConstructOutMessage(reverse_partition);
+        layout.permutation = detail::ConstructPermutation(reverse_partition);
+        const auto& out_message = layout.out_message;
         // use permutation array to send the gids
         std::vector<pcms::GO> gid_msgs(gids.size());
-        REDEV_ALWAYS_ASSERT(gids.size() == message_permutation_.size());
+        REDEV_ALWAYS_ASSERT(gids.size() == layout.permutation.size());
         for (size_t i = 0; i < gids.size(); ++i) {
-          gid_msgs[message_permutation_[i]] = gids[i];
+          gid_msgs[layout.permutation[i]] = gids[i];
+        }
+        auto key = detail::MakeMessageLayoutKey(gids, out_message, gid_msgs);
+        bool cached = false;
+        if (UseLayoutCache()) {
+          cached = LayoutHandshakeClient(out_message, key.checksums);
         }
         channel_.BeginSendCommunicationPhase();
-        gid_comm_.Send(gid_msgs.data());
+        if (!cached) {
+          // contiguous gids are sent as ranges, which shrinks the message of
+          // a mostly contiguous numbering to a few entries
+          const auto encoded = detail::EncodeGidMessages(out_message, gid_msgs);
+          gid_comm_.SetOutMessageLayout(out_message.dest, encoded.offset);
+          gid_comm_.Send(encoded.data.data());
+        }
         channel_.EndSendCommunicationPhase();
+        SetLayout(std::move(key), std::move(layout));
       } else {
-        channel_.BeginReceiveCommunicationPhase();
-        auto recv_gids = gid_comm_.Recv();
-        channel_.EndReceiveCommunicationPhase();
         int rank, nproc;
         MPI_Comm_rank(mpi_comm_, &rank);
         MPI_Comm_size(mpi_comm_, &nproc);
-        // we require that the layout for the gids and the message are the same
-        const auto in_message_layout = gid_comm_.GetInMessageLayout();
-        auto out_message =
-          detail::ConstructOutMessage(rank, nproc, in_message_layout);
-        comm_.SetOutMessageLayout(out_message.dest, out_message.offset);
-        // construct server permutation array
-        // Verify that there are no duplicate entries in the received
-        // data. Duplicate data indicates that sender is not sending data from
-        // only the owned rank
-        REDEV_ALWAYS_ASSERT(!detail::HasDuplicates(recv_gids));
-        message_permutation_ = detail::ConstructPermutation(gids, recv_gids);
+        detail::CachedLayout cached_layout;
+        bool cached = false;
+        if (UseLayoutCache()) {
+          cached = LayoutHandshakeServer(rank, nproc, gids, cached_layout);
+        }
+        channel_.BeginReceiveCommunicationPhase();
+        std::vector<GO> encoded_gids;
+        if (!cached) {
+          encoded_gids = gid_comm_.Recv();
+        }
+        channel_.EndReceiveCommunicationPhase();
+        if (cached) {
+          SetLayout(std::move(cached_layout.key),
+                    std::move(cached_layout.layout));
+        } else {
+          // the layout of the field messages is the layout of the decoded
+          // gids
+          const auto encoded_layout = detail::ConstructOutMessage(
+            rank, nproc, gid_comm_.GetInMessageLayout());
+          auto [out_message, recv_gids] =
+            detail::DecodeGidMessages(encoded_layout, encoded_gids);
+          auto key = detail::MakeMessageLayoutKey(gids, out_message, recv_gids);
+          // a field with the same gids and partition was already set up, so
+          // its permutation is reused
+          auto shared =
+            layout_registry_ ? layout_registry_->Find(key) : nullptr;
+          if (shared) {
+            layout_ = std::move(shared);
+          } else {
+            // construct server permutation array, which also verifies that
+            // there are no duplicate entries in the received data
+            detail::MessageLayout layout;
+            layout.out_message = std::move(out_message);
+            layout.permutation = detail::ConstructPermutation(gids, recv_gids);
+            SetLayout(key, std::move(layout));
+          }
+          if (UseLayoutCache()) {
+            detail::WriteLayoutCache(
+              detail::LayoutCachePath(layout_cache_directory_, name_, rank),
+              {std::move(key), *layout_});
+          }
+        }
       }
-      comm_buffer_.resize(message_permutation_.size());
+      SetDataLayout();
+      message_size_ = layout_->permutation.size();
+      comm_buffer_.resize(message_size_);
     //}
   }
+  // shares the layout with the other fields in the registry that have the
+  // same key
+  void SetLayout(detail::MessageLayoutKey key, detail::MessageLayout layout)
+  {
+    if (layout_registry_) {
+      layout_ = layout_registry_->Insert(std::move(key), std::move(layout));
+    } else {
+      layout_ =
+        std::make_shared<const detail::MessageLayout>(std::move(layout));
+    }
+  }
+  // tells the receivers whether the field changed since it was last sent and
+  // returns true if it did. The decision is the same on all ranks, since the
+  // data message is sent by all ranks or none
+  bool SendDeltaHeader(Mode mode)
+  {
+    PCMS_FUNCTION_TIMER;
+    int changed =
+      !has_snapshot_ ||
+      detail::MessageChanged(comm_buffer_, sent_snapshot_, *delta_threshold_);
+    if (mpi_comm_ != MPI_COMM_NULL) {
+      MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, mpi_comm_);
+    }
+    std::fill(delta_header_.begin(), delta_header_.end(), changed);
+    delta_comm_.Send(delta_header_.data(), mode);
+    if (changed) {
+      sent_snapshot_ = comm_buffer_;
+      has_snapshot_ = true;
+    }
+    return changed;
+  }
+  bool ReceiveDeltaHeader()
+  {
+    PCMS_FUNCTION_TIMER;
+    const auto header = delta_comm_.Recv(Mode::Synchronous);
+    int changed = std::any_of(header.begin(), header.end(),
+                              [](GO flag) { return flag != 0; });
+    // ranks that receive nothing from the senders still need to agree
+    if (mpi_comm_ != MPI_COMM_NULL) {
+      MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, mpi_comm_);
+    }
+    return changed;
+  }
+  // the layout of the field messages for the comm of the wire encoding
+  void SetDataLayout()
+  {
+    const auto& out_message = layout_->out_message;
+    if (delta_threshold_) {
+      // one flag per destination
+      redev::LOs offset(out_message.dest.size() + 1);
+      std::iota(offset.begin(), offset.end(), 0);
+      delta_comm_.SetOutMessageLayout(out_message.dest, offset);
+      delta_header_.resize(out_message.dest.size());
+    }
+    switch (wire_encoding_) {
+      case WireEncoding::Native:
+        comm_.SetOutMessageLayout(out_message.dest, out_message.offset);
+        break;
+      case WireEncoding::Float32:
+        float_comm_.SetOutMessageLayout(out_message.dest, out_message.offset);
+        break;
+      case WireEncoding::Quantized16:
+        quantized_comm_.SetOutMessageLayout(
+          out_message.dest, detail::QuantizedMessageOffsets(out_message));
+        break;
+    }
+  }
+  [[nodiscard]] bool UseLayoutCache() const noexcept
+  {
+    return !layout_cache_directory_.empty();
+  }
+  // sends the hash of the gid message to each destination and returns true
+  // if all server ranks accepted their cached layouts
+  bool LayoutHandshakeClient(const detail::OutMsg& out_message,
+                             const std::vector<GO>& checksums)
+  {
+    PCMS_FUNCTION_TIMER;
+    redev::LOs offset(out_message.dest.size() + 1);
+    std::iota(offset.begin(), offset.end(), 0);
+    layout_comm_.SetOutMessageLayout(out_message.dest, offset);
+    channel_.BeginSendCommunicationPhase();
+    layout_comm_.Send(checksums.data());
+    channel_.EndSendCommunicationPhase();
+    channel_.BeginReceiveCommunicationPhase();
+    auto accepted = layout_comm_.Recv();
+    channel_.EndReceiveCommunicationPhase();
+    int valid = std::all_of(accepted.begin(), accepted.end(),
+                            [](GO a) { return a == 1; });
+    MPI_Allreduce(MPI_IN_PLACE, &valid, 1, MPI_INT, MPI_MIN, mpi_comm_);
+    return valid;
+  }
+  // compares the hashes sent by the clients with the cached layout and
+  // replies to the clients whether the cached layouts can be used. The
+  // handshake is stored in layout so an updated cache can be written
+  bool LayoutHandshakeServer(int rank, int nproc, const std::vector<GO>& gids,
+                             detail::CachedLayout& layout)
+  {
+    PCMS_FUNCTION_TIMER;
+    channel_.BeginReceiveCommunicationPhase();
+    auto checksums = layout_comm_.Recv();
+    channel_.EndReceiveCommunicationPhase();
+    auto sources = detail::ConstructOutMessage(
+      rank, nproc, layout_comm_.GetInMessageLayout());
+
+    const auto path =
+      detail::LayoutCachePath(layout_cache_directory_, name_, rank);
+    auto& key = layout.key;
+    const GO gid_hash = detail::HashGids(gids.data(), gids.size());
+    int valid = detail::ReadLayoutCache(path, layout) &&
+                key.gid_hash == gid_hash && key.sources == sources.dest &&
+                key.checksums == checksums;
+    MPI_Allreduce(MPI_IN_PLACE, &valid, 1, MPI_INT, MPI_MIN, mpi_comm_);
+    key.gid_hash = gid_hash;
+    key.sources = std::move(sources.dest);
+    key.checksums = std::move(checksums);
+
+    std::vector<GO> accepted(key.sources.size(), valid);
+    layout_comm_.SetOutMessageLayout(key.sources, sources.offset);
+    channel_.BeginSendCommunicationPhase();
+    layout_comm_.Send(accepted.data());
+    channel_.EndSendCommunicationPhase();
+    return valid;
+  }
+  void DeserializeReceived()
+  {
+    PCMS_FUNCTION_TIMER;
+    // decoding happens here so that deferred receives decode after the phase
+    switch (wire_encoding_) {
+      case WireEncoding::Native: break;
+      case WireEncoding::Float32:
+        recv_buffer_.assign(float_recv_buffer_.begin(),
+                            float_recv_buffer_.end());
+        break;
+      case WireEncoding::Quantized16:
+        recv_buffer_.resize(message_size_);
+        detail::DequantizeMessages(layout_->out_message,
+                                   quantized_recv_buffer_, recv_buffer_.data());
+        break;
+    }
+    field_adapter_.Deserialize(make_const_array_view(recv_buffer_),
+                               make_const_array_view(layout_->permutation));
+    receive_pending_ = false;
+  }
   void UpdateLayoutNull()
   {
     PCMS_FUNCTION_TIMER;
     //if (mpi_comm_ != MPI_COMM_NULL) {
     if (redev_.GetProcessType() == redev::ProcessType::Client) {
+      if (UseLayoutCache()) {
+        channel_.BeginSendCommunicationPhase();
+        channel_.EndSendCommunicationPhase();
+        channel_.BeginReceiveCommunicationPhase();
+        channel_.EndReceiveCommunicationPhase();
+      }
       channel_.BeginSendCommunicationPhase();
       channel_.EndSendCommunicationPhase();
     } else {
+      if (UseLayoutCache()) {
+        channel_.BeginReceiveCommunicationPhase();
+        channel_.EndReceiveCommunicationPhase();
+        channel_.BeginSendCommunicationPhase();
+        channel_.EndSendCommunicationPhase();
+      }
       channel_.BeginReceiveCommunicationPhase();
       channel_.EndReceiveCommunicationPhase();
     }
@@ -256,21 +730,212 @@ private:
   MPI_Comm mpi_comm_;
   redev::Channel& channel_;
   std::vector<T> comm_buffer_;
-  std::vector<pcms::LO> message_permutation_;
+  std::vector<T> recv_buffer_;
+  // number of values in the message of the field, set by UpdateLayout
+  size_t message_size_ = 0;
+  bool receive_pending_ = false;
+  // layout and permutation of the messages, possibly shared with other
+  // fields
+  std::shared_ptr<const detail::MessageLayout> layout_;
+  std::shared_ptr<detail::MessageLayoutRegistry> layout_registry_;
   redev::BidirectionalComm<T> comm_;
+  // comms and buffers of the reduced precision wire encodings
+  redev::BidirectionalComm<float> float_comm_;
+  redev::BidirectionalComm<detail::QuantizedValue> quantized_comm_;
+  std::vector<float> float_buffer_;
+  std::vector<float> float_recv_buffer_;
+  std::vector<detail::QuantizedValue> quantized_buffer_;
+  std::vector<detail::QuantizedValue> quantized_recv_buffer_;
   redev::BidirectionalComm<GO> gid_comm_;
+  redev::BidirectionalComm<GO> layout_comm_;
+  // header and last sent values of delta transfers
+  redev::BidirectionalComm<GO> delta_comm_;
+  std::vector<GO> delta_header_;
+  std::vector<T> sent_snapshot_;
+  bool has_snapshot_ = false;
   bool buffer_size_needs_update_;
   // Stored functions used for updated field
   // info/serialization/deserialization
   FieldAdapterT& field_adapter_;
   redev::Redev& redev_;
   std::string name_;
+  std::string layout_cache_directory_;
+  WireEncoding wire_encoding_;
+  std::optional<double> delta_threshold_;
 };
 template <>
 struct FieldCommunicator<void>
 {
   void Send(Mode = {}) {}
   void Receive(Mode = {}) {}
+  void FinishReceive() {}
+};
+
+// communicates a group of fields that share a message layout with a single
+// message per destination rank. The message to each rank holds the segment of
+// every field for that rank one after the other, in the order of the fields
+template <typename T>
+class FieldGroupCommunicator
+{
+public:
+  FieldGroupCommunicator(const std::string& name, redev::Channel& channel,
+                         std::vector<detail::MessagePacker<T>*> fields)
+    : channel_(channel), fields_(std::move(fields))
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(!fields_.empty());
+    const auto& layout = fields_.front()->GetMessageLayout();
+    const auto mpi_comm = fields_.front()->GetMPIComm();
+    for (const auto* field : fields_) {
+      // only fields with identical partitions can be packed together
+      PCMS_ALWAYS_ASSERT(field->GetMessageLayout().dest == layout.dest);
+      PCMS_ALWAYS_ASSERT(field->GetMessageLayout().offset == layout.offset);
+      PCMS_ALWAYS_ASSERT((field->GetMPIComm() == MPI_COMM_NULL) ==
+                         (mpi_comm == MPI_COMM_NULL));
+    }
+    comm_ = channel.CreateComm<T>(name, mpi_comm);
+    if (mpi_comm != MPI_COMM_NULL) {
+      const auto nfields = static_cast<redev::LO>(fields_.size());
+      redev::LOs offset(layout.offset);
+      for (auto& o : offset) {
+        o *= nfields;
+      }
+      comm_.SetOutMessageLayout(layout.dest, offset);
+    }
+    const size_t field_size = layout.offset.empty() ? 0 : layout.offset.back();
+    field_buffer_.resize(field_size);
+    comm_buffer_.resize(field_size * fields_.size());
+  }
+  FieldGroupCommunicator(const FieldGroupCommunicator&) = delete;
+  FieldGroupCommunicator(FieldGroupCommunicator&&) = default;
+  FieldGroupCommunicator& operator=(const FieldGroupCommunicator&) = delete;
+  FieldGroupCommunicator& operator=(FieldGroupCommunicator&&) = default;
+
+  void Send(Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(channel_.InSendCommunicationPhase());
+    for (size_t i = 0; i < fields_.size(); ++i) {
+      fields_[i]->SerializeMessage(make_array_view(field_buffer_));
+      ForEachSegment(i, [&](size_t field_index, size_t message_index) {
+        comm_buffer_[message_index] = field_buffer_[field_index];
+      });
+    }
+    comm_.Send(comm_buffer_.data(), mode);
+  }
+  // same as FieldCommunicator::Receive, a deferred receive is unpacked by
+  // FinishReceive after the receive phase
+  void Receive(Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(channel_.InReceiveCommunicationPhase());
+    PCMS_ALWAYS_ASSERT(!receive_pending_);
+    recv_buffer_ = comm_.Recv(mode);
+    receive_pending_ = true;
+    if (mode == Mode::Synchronous) {
+      Unpack();
+    }
+  }
+  void FinishReceive()
+  {
+    PCMS_FUNCTION_TIMER;
+    if (receive_pending_) {
+      PCMS_ALWAYS_ASSERT(!channel_.InReceiveCommunicationPhase());
+      Unpack();
+    }
+  }
+
+private:
+  void Unpack()
+  {
+    PCMS_FUNCTION_TIMER;
+    REDEV_ALWAYS_ASSERT(recv_buffer_.size() == comm_buffer_.size());
+    for (size_t i = 0; i < fields_.size(); ++i) {
+      ForEachSegment(i, [&](size_t field_index, size_t message_index) {
+        field_buffer_[field_index] = recv_buffer_[message_index];
+      });
+      fields_[i]->DeserializeMessage(make_const_array_view(field_buffer_));
+    }
+    receive_pending_ = false;
+  }
+  // calls func with the index of each entry of field i in its own message
+  // and in the message of the group
+  template <typename Func>
+  void ForEachSegment(size_t i, const Func& func) const
+  {
+    const auto& offset = fields_.front()->GetMessageLayout().offset;
+    const auto nfields = fields_.size();
+    for (size_t r = 0; r + 1 < offset.size(); ++r) {
+      const size_t begin = offset[r];
+      const size_t length = offset[r + 1] - begin;
+      const size_t message_begin = begin * nfields + i * length;
+      for (size_t j = 0; j < length; ++j) {
+        func(begin + j, message_begin + j);
+      }
+    }
+  }
+
+  redev::Channel& channel_;
+  std::vector<detail::MessagePacker<T>*> fields_;
+  redev::BidirectionalComm<T> comm_;
+  std::vector<T> field_buffer_;
+  std::vector<T> comm_buffer_;
+  std::vector<T> recv_buffer_;
+  bool receive_pending_ = false;
+};
+
+// type erased group of fields that are sent and received as a single message
+class FieldGroup
+{
+public:
+  template <typename T>
+  FieldGroup(std::in_place_type_t<T>, const std::string& name,
+             redev::Channel& channel,
+             std::vector<detail::MessagePacker<T>*> fields)
+    : field_group_(std::make_unique<FieldGroupModel<T>>(name, channel,
+                                                        std::move(fields)))
+  {
+    PCMS_FUNCTION_TIMER;
+  }
+  void Send(Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    field_group_->Send(mode);
+  }
+  void Receive(Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    field_group_->Receive(mode);
+  }
+  void FinishReceive()
+  {
+    PCMS_FUNCTION_TIMER;
+    field_group_->FinishReceive();
+  }
+
+private:
+  struct FieldGroupConcept
+  {
+    virtual void Send(Mode) = 0;
+    virtual void Receive(Mode) = 0;
+    virtual void FinishReceive() = 0;
+    virtual ~FieldGroupConcept() = default;
+  };
+  template <typename T>
+  struct FieldGroupModel final : FieldGroupConcept
+  {
+    FieldGroupModel(const std::string& name, redev::Channel& channel,
+                    std::vector<detail::MessagePacker<T>*> fields)
+      : comm_(name, channel, std::move(fields))
+    {
+    }
+    void Send(Mode mode) final { comm_.Send(mode); }
+    void Receive(Mode mode) final { comm_.Receive(mode); }
+    void FinishReceive() final { comm_.FinishReceive(); }
+
+    FieldGroupCommunicator<T> comm_;
+  };
+  std::unique_ptr<FieldGroupConcept> field_group_;
 };
 } // namespace pcms
 
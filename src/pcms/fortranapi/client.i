@@ -27,10 +27,17 @@ enum PcmsType
   PCMS_INT,
   PCMS_LONG_INT
 };
+enum PcmsWireEncoding
+{
+  PCMS_WIRE_NATIVE,
+  PCMS_WIRE_FLOAT32,
+  PCMS_WIRE_QUANTIZED16
+};
 
 
 PcmsClientHandle* pcms_create_client(const char* name, MPI_Comm comm);
 void pcms_destroy_client(PcmsClientHandle*);
+void pcms_enable_layout_cache(PcmsClientHandle*, const char* directory);
 
 PcmsReverseClassificationHandle* pcms_load_reverse_classification(
   const char* file, MPI_Comm comm);
@@ -52,12 +59,25 @@ PcmsFieldHandle* pcms_add_field(PcmsClientHandle* client_handle,
                                     const char* name,
                                     PcmsFieldAdapterHandle* adapter_handle,
                                     int participates);
+PcmsFieldHandle* pcms_add_field_ex(PcmsClientHandle* client_handle,
+                                   const char* name,
+                                   PcmsFieldAdapterHandle* adapter_handle,
+                                   int participates,
+                                   PcmsWireEncoding wire_encoding,
+                                   double delta_threshold);
 void pcms_send_field_name(PcmsClientHandle*, const char* name);
 void pcms_receive_field_name(PcmsClientHandle*, const char* name);
 
 void pcms_send_field(PcmsFieldHandle*);
 void pcms_receive_field(PcmsFieldHandle*);
 
+PcmsFieldGroupHandle* pcms_add_field_group(PcmsClientHandle* client_handle,
+                                           const char* name,
+                                           const char* field_names,
+                                           PcmsType data_type);
+void pcms_send_field_group(PcmsFieldGroupHandle*);
+void pcms_receive_field_group(PcmsFieldGroupHandle*);
+
 void pcms_begin_send_phase(PcmsClientHandle*);
 void pcms_end_send_phase(PcmsClientHandle*);
 void pcms_begin_receive_phase(PcmsClientHandle*);
@@ -252,6 +252,16 @@ SWIGEXPORT void _wrap_pcms_destroy_client(SwigClassWrapper *farg1) {
 }
 
 
+SWIGEXPORT void _wrap_pcms_enable_layout_cache(SwigClassWrapper *farg1, SwigArrayWrapper *farg2) {
+  PcmsClientHandle *arg1 = (PcmsClientHandle *) 0 ;
+  char *arg2 = (char *) 0 ;
+  
+  arg1 = (PcmsClientHandle *)farg1->cptr;
+  arg2 = (char *)(farg2->data);
+  pcms_enable_layout_cache(arg1,(char const *)arg2);
+}
+
+
 SWIGEXPORT SwigClassWrapper _wrap_pcms_load_reverse_classification(SwigArrayWrapper *farg1, int const *farg2) {
   SwigClassWrapper fresult ;
   char *arg1 = (char *) 0 ;
@@ -358,6 +368,29 @@ SWIGEXPORT SwigClassWrapper _wrap_pcms_add_field(SwigClassWrapper *farg1, SwigAr
 }
 
 
+SWIGEXPORT SwigClassWrapper _wrap_pcms_add_field_ex(SwigClassWrapper *farg1, SwigArrayWrapper *farg2, SwigClassWrapper *farg3, int const *farg4, int const *farg5, double const *farg6) {
+  SwigClassWrapper fresult ;
+  PcmsClientHandle *arg1 = (PcmsClientHandle *) 0 ;
+  char *arg2 = (char *) 0 ;
+  PcmsFieldAdapterHandle *arg3 = (PcmsFieldAdapterHandle *) 0 ;
+  int arg4 ;
+  PcmsWireEncoding arg5 ;
+  double arg6 ;
+  PcmsFieldHandle *result = 0 ;
+  
+  arg1 = (PcmsClientHandle *)farg1->cptr;
+  arg2 = (char *)(farg2->data);
+  arg3 = (PcmsFieldAdapterHandle *)farg3->cptr;
+  arg4 = (int)(*farg4);
+  arg5 = (PcmsWireEncoding)(*farg5);
+  arg6 = (double)(*farg6);
+  result = (PcmsFieldHandle *)pcms_add_field_ex(arg1,(char const *)arg2,arg3,arg4,arg5,arg6);
+  fresult.cptr = (void*)result;
+  fresult.cmemflags = SWIG_MEM_RVALUE | (0 ? SWIG_MEM_OWN : 0);
+  return fresult;
+}
+
+
 SWIGEXPORT void _wrap_pcms_send_field_name(SwigClassWrapper *farg1, SwigArrayWrapper *farg2) {
   PcmsClientHandle *arg1 = (PcmsClientHandle *) 0 ;
   char *arg2 = (char *) 0 ;
@@ -394,6 +427,41 @@ SWIGEXPORT void _wrap_pcms_receive_field(SwigClassWrapper *farg1) {
 }
 
 
+SWIGEXPORT SwigClassWrapper _wrap_pcms_add_field_group(SwigClassWrapper *farg1, SwigArrayWrapper *farg2, SwigArrayWrapper *farg3, int const *farg4) {
+  SwigClassWrapper fresult ;
+  PcmsClientHandle *arg1 = (PcmsClientHandle *) 0 ;
+  char *arg2 = (char *) 0 ;
+  char *arg3 = (char *) 0 ;
+  PcmsType arg4 ;
+  PcmsFieldGroupHandle *result = 0 ;
+  
+  arg1 = (PcmsClientHandle *)farg1->cptr;
+  arg2 = (char *)(farg2->data);
+  arg3 = (char *)(farg3->data);
+  arg4 = (PcmsType)(*farg4);
+  result = (PcmsFieldGroupHandle *)pcms_add_field_group(arg1,(char const *)arg2,(char const *)arg3,arg4);
+  fresult.cptr = (void*)result;
+  fresult.cmemflags = SWIG_MEM_RVALUE | (0 ? SWIG_MEM_OWN : 0);
+  return fresult;
+}
+
+
+SWIGEXPORT void _wrap_pcms_send_field_group(SwigClassWrapper *farg1) {
+  PcmsFieldGroupHandle *arg1 = (PcmsFieldGroupHandle *) 0 ;
+  
+  arg1 = (PcmsFieldGroupHandle *)farg1->cptr;
+  pcms_send_field_group(arg1);
+}
+
+
+SWIGEXPORT void _wrap_pcms_receive_field_group(SwigClassWrapper *farg1) {
+  PcmsFieldGroupHandle *arg1 = (PcmsFieldGroupHandle *) 0 ;
+  
+  arg1 = (PcmsFieldGroupHandle *)farg1->cptr;
+  pcms_receive_field_group(arg1);
+}
+
+
 SWIGEXPORT void _wrap_pcms_begin_send_phase(SwigClassWrapper *farg1) {
   PcmsClientHandle *arg1 = (PcmsClientHandle *) 0 ;
   
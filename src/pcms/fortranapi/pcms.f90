@@ -28,6 +28,14 @@ module pcms
  end enum
  integer, parameter, public :: PcmsType = kind(PCMS_FLOAT)
  public :: PCMS_FLOAT, PCMS_DOUBLE, PCMS_INT, PCMS_LONG_INT
+ ! enum PcmsWireEncoding
+ enum, bind(c)
+  enumerator :: PCMS_WIRE_NATIVE
+  enumerator :: PCMS_WIRE_FLOAT32
+  enumerator :: PCMS_WIRE_QUANTIZED16
+ end enum
+ integer, parameter, public :: PcmsWireEncoding = kind(PCMS_WIRE_NATIVE)
+ public :: PCMS_WIRE_NATIVE, PCMS_WIRE_FLOAT32, PCMS_WIRE_QUANTIZED16
 
  integer, parameter :: swig_cmem_own_bit = 0
  integer, parameter :: swig_cmem_rvalue_bit = 1
@@ -44,6 +52,7 @@ module pcms
  end type
  public :: pcms_create_client
  public :: pcms_destroy_client
+ public :: pcms_enable_layout_cache
  type, public :: SWIGTYPE_p_PcmsReverseClassificationHandle
   type(SwigClassWrapper), public :: swigdata
  end type
@@ -60,10 +69,17 @@ module pcms
   type(SwigClassWrapper), public :: swigdata
  end type
  public :: pcms_add_field
+ public :: pcms_add_field_ex
  public :: pcms_send_field_name
  public :: pcms_receive_field_name
  public :: pcms_send_field
  public :: pcms_receive_field
+ type, public :: SWIGTYPE_p_PcmsFieldGroupHandle
+  type(SwigClassWrapper), public :: swigdata
+ end type
+ public :: pcms_add_field_group
+ public :: pcms_send_field_group
+ public :: pcms_receive_field_group
  public :: pcms_begin_send_phase
  public :: pcms_end_send_phase
  public :: pcms_begin_receive_phase
@@ -105,6 +121,15 @@ import :: swigclasswrapper
 type(SwigClassWrapper), intent(in) :: farg1
 end subroutine
 
+subroutine swigc_pcms_enable_layout_cache(farg1, farg2) &
+bind(C, name="_wrap_pcms_enable_layout_cache")
+use, intrinsic :: ISO_C_BINDING
+import :: swigarraywrapper
+import :: swigclasswrapper
+type(SwigClassWrapper), intent(in) :: farg1
+type(SwigArrayWrapper) :: farg2
+end subroutine
+
 function swigc_pcms_load_reverse_classification(farg1, farg2) &
 bind(C, name="_wrap_pcms_load_reverse_classification") &
 result(fresult)
@@ -176,6 +201,21 @@ integer(C_INT), intent(in) :: farg4
 type(SwigClassWrapper) :: fresult
 end function
 
+function swigc_pcms_add_field_ex(farg1, farg2, farg3, farg4, farg5, farg6) &
+bind(C, name="_wrap_pcms_add_field_ex") &
+result(fresult)
+use, intrinsic :: ISO_C_BINDING
+import :: swigarraywrapper
+import :: swigclasswrapper
+type(SwigClassWrapper), intent(in) :: farg1
+type(SwigArrayWrapper) :: farg2
+type(SwigClassWrapper), intent(in) :: farg3
+integer(C_INT), intent(in) :: farg4
+integer(C_INT), intent(in) :: farg5
+real(C_DOUBLE), intent(in) :: farg6
+type(SwigClassWrapper) :: fresult
+end function
+
 subroutine swigc_pcms_send_field_name(farg1, farg2) &
 bind(C, name="_wrap_pcms_send_field_name")
 use, intrinsic :: ISO_C_BINDING
@@ -208,6 +248,33 @@ import :: swigclasswrapper
 type(SwigClassWrapper), intent(in) :: farg1
 end subroutine
 
+function swigc_pcms_add_field_group(farg1, farg2, farg3, farg4) &
+bind(C, name="_wrap_pcms_add_field_group") &
+result(fresult)
+use, intrinsic :: ISO_C_BINDING
+import :: swigarraywrapper
+import :: swigclasswrapper
+type(SwigClassWrapper), intent(in) :: farg1
+type(SwigArrayWrapper) :: farg2
+type(SwigArrayWrapper) :: farg3
+integer(C_INT), intent(in) :: farg4
+type(SwigClassWrapper) :: fresult
+end function
+
+subroutine swigc_pcms_send_field_group(farg1) &
+bind(C, name="_wrap_pcms_send_field_group")
+use, intrinsic :: ISO_C_BINDING
+import :: swigclasswrapper
+type(SwigClassWrapper), intent(in) :: farg1
+end subroutine
+
+subroutine swigc_pcms_receive_field_group(farg1) &
+bind(C, name="_wrap_pcms_receive_field_group")
+use, intrinsic :: ISO_C_BINDING
+import :: swigclasswrapper
+type(SwigClassWrapper), intent(in) :: farg1
+end subroutine
+
 subroutine swigc_pcms_begin_send_phase(farg1) &
 bind(C, name="_wrap_pcms_begin_send_phase")
 use, intrinsic :: ISO_C_BINDING
@@ -295,6 +362,19 @@ farg1 = arg0%swigdata
 call swigc_pcms_destroy_client(farg1)
 end subroutine
 
+subroutine pcms_enable_layout_cache(arg0, directory)
+use, intrinsic :: ISO_C_BINDING
+class(SWIGTYPE_p_PcmsClientHandle), intent(in) :: arg0
+character(len=*), target :: directory
+type(SwigClassWrapper) :: farg1 
+character(kind=C_CHAR), dimension(:), allocatable, target :: farg2_temp 
+type(SwigArrayWrapper) :: farg2 
+
+farg1 = arg0%swigdata
+call SWIGTM_fin_char_Sm_(directory, farg2, farg2_temp)
+call swigc_pcms_enable_layout_cache(farg1, farg2)
+end subroutine
+
 function pcms_load_reverse_classification(file, comm) &
 result(swig_result)
 use, intrinsic :: ISO_C_BINDING
@@ -408,6 +488,35 @@ fresult = swigc_pcms_add_field(farg1, farg2, farg3, farg4)
 swig_result%swigdata = fresult
 end function
 
+function pcms_add_field_ex(client_handle, name, adapter_handle, participates, wire_encoding, delta_threshold) &
+result(swig_result)
+use, intrinsic :: ISO_C_BINDING
+type(SWIGTYPE_p_PcmsFieldHandle) :: swig_result
+class(SWIGTYPE_p_PcmsClientHandle), intent(in) :: client_handle
+character(len=*), target :: name
+class(SWIGTYPE_p_PcmsFieldAdapterHandle), intent(in) :: adapter_handle
+integer(C_INT), intent(in) :: participates
+integer(PcmsWireEncoding), intent(in) :: wire_encoding
+real(C_DOUBLE), intent(in) :: delta_threshold
+type(SwigClassWrapper) :: fresult 
+type(SwigClassWrapper) :: farg1 
+character(kind=C_CHAR), dimension(:), allocatable, target :: farg2_temp 
+type(SwigArrayWrapper) :: farg2 
+type(SwigClassWrapper) :: farg3 
+integer(C_INT) :: farg4 
+integer(C_INT) :: farg5 
+real(C_DOUBLE) :: farg6 
+
+farg1 = client_handle%swigdata
+call SWIGTM_fin_char_Sm_(name, farg2, farg2_temp)
+farg3 = adapter_handle%swigdata
+farg4 = participates
+farg5 = wire_encoding
+farg6 = delta_threshold
+fresult = swigc_pcms_add_field_ex(farg1, farg2, farg3, farg4, farg5, farg6)
+swig_result%swigdata = fresult
+end function
+
 subroutine pcms_send_field_name(arg0, name)
 use, intrinsic :: ISO_C_BINDING
 class(SWIGTYPE_p_PcmsClientHandle), intent(in) :: arg0
@@ -452,6 +561,48 @@ farg1 = arg0%swigdata
 call swigc_pcms_receive_field(farg1)
 end subroutine
 
+function pcms_add_field_group(client_handle, name, field_names, data_type) &
+result(swig_result)
+use, intrinsic :: ISO_C_BINDING
+type(SWIGTYPE_p_PcmsFieldGroupHandle) :: swig_result
+class(SWIGTYPE_p_PcmsClientHandle), intent(in) :: client_handle
+character(len=*), target :: name
+character(len=*), target :: field_names
+integer(PcmsType), intent(in) :: data_type
+type(SwigClassWrapper) :: fresult 
+type(SwigClassWrapper) :: farg1 
+character(kind=C_CHAR), dimension(:), allocatable, target :: farg2_temp 
+type(SwigArrayWrapper) :: farg2 
+character(kind=C_CHAR), dimension(:), allocatable, target :: farg3_temp 
+type(SwigArrayWrapper) :: farg3 
+integer(C_INT) :: farg4 
+
+farg1 = client_handle%swigdata
+call SWIGTM_fin_char_Sm_(name, farg2, farg2_temp)
+call SWIGTM_fin_char_Sm_(field_names, farg3, farg3_temp)
+farg4 = data_type
+fresult = swigc_pcms_add_field_group(farg1, farg2, farg3, farg4)
+swig_result%swigdata = fresult
+end function
+
+subroutine pcms_send_field_group(arg0)
+use, intrinsic :: ISO_C_BINDING
+class(SWIGTYPE_p_PcmsFieldGroupHandle), intent(in) :: arg0
+type(SwigClassWrapper) :: farg1 
+
+farg1 = arg0%swigdata
+call swigc_pcms_send_field_group(farg1)
+end subroutine
+
+subroutine pcms_receive_field_group(arg0)
+use, intrinsic :: ISO_C_BINDING
+class(SWIGTYPE_p_PcmsFieldGroupHandle), intent(in) :: arg0
+type(SwigClassWrapper) :: farg1 
+
+farg1 = arg0%swigdata
+call swigc_pcms_receive_field_group(farg1)
+end subroutine
+
 subroutine pcms_begin_send_phase(arg0)
 use, intrinsic :: ISO_C_BINDING
 class(SWIGTYPE_p_PcmsClientHandle), intent(in) :: arg0
@@ -0,0 +1,108 @@
+#ifndef PCMS_COUPLING_LAYOUT_CACHE_H
+#define PCMS_COUPLING_LAYOUT_CACHE_H
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "pcms/message_layout.h"
+#include "pcms/profile.h"
+
+namespace pcms
+{
+namespace detail
+{
+// message layout and permutation of a field on the server, along with the
+// key of the client messages it was built from
+struct CachedLayout
+{
+  MessageLayoutKey key;
+  MessageLayout layout;
+};
+
+namespace layout_cache
+{
+constexpr std::uint64_t magic = 0x70636d736c61796fULL; // "pcmslayo"
+
+template <typename T>
+void WriteVector(std::ofstream& file, const std::vector<T>& v)
+{
+  const std::uint64_t n = v.size();
+  file.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  file.write(reinterpret_cast<const char*>(v.data()), n * sizeof(T));
+}
+template <typename T>
+bool ReadVector(std::ifstream& file, std::vector<T>& v)
+{
+  std::uint64_t n = 0;
+  if (!file.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+    return false;
+  }
+  // the length comes from the file, so a truncated or corrupt cache must not
+  // allocate more than the file can hold
+  const auto position = file.tellg();
+  if (position < 0 || !file.seekg(0, std::ios::end)) {
+    return false;
+  }
+  const auto remaining =
+    static_cast<std::uint64_t>(file.tellg() - position);
+  if (!file.seekg(position) || n > remaining / sizeof(T)) {
+    return false;
+  }
+  v.resize(n);
+  return static_cast<bool>(
+    file.read(reinterpret_cast<char*>(v.data()), n * sizeof(T)));
+}
+} // namespace layout_cache
+
+// path of the cached layout of a field on the given rank
+inline std::string LayoutCachePath(const std::string& directory,
+                                   const std::string& name, int rank)
+{
+  return directory + "/" + name + "." + std::to_string(rank) + ".layout";
+}
+
+// returns false if there is no readable cache file
+inline bool ReadLayoutCache(const std::string& path, CachedLayout& layout)
+{
+  PCMS_FUNCTION_TIMER;
+  std::ifstream file(path, std::ios::binary);
+  std::uint64_t magic = 0;
+  if (!file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) ||
+      magic != layout_cache::magic) {
+    return false;
+  }
+  auto& key = layout.key;
+  auto& out_message = layout.layout.out_message;
+  return file.read(reinterpret_cast<char*>(&key.gid_hash),
+                   sizeof(key.gid_hash)) &&
+         layout_cache::ReadVector(file, key.sources) &&
+         layout_cache::ReadVector(file, key.checksums) &&
+         layout_cache::ReadVector(file, out_message.dest) &&
+         layout_cache::ReadVector(file, out_message.offset) &&
+         layout_cache::ReadVector(file, layout.layout.permutation);
+}
+
+// a layout that can not be written only costs the full exchange on the next
+// start, so failures are not fatal
+inline bool WriteLayoutCache(const std::string& path,
+                             const CachedLayout& layout)
+{
+  PCMS_FUNCTION_TIMER;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&layout_cache::magic),
+             sizeof(layout_cache::magic));
+  const auto& key = layout.key;
+  const auto& out_message = layout.layout.out_message;
+  file.write(reinterpret_cast<const char*>(&key.gid_hash),
+             sizeof(key.gid_hash));
+  layout_cache::WriteVector(file, key.sources);
+  layout_cache::WriteVector(file, key.checksums);
+  layout_cache::WriteVector(file, out_message.dest);
+  layout_cache::WriteVector(file, out_message.offset);
+  layout_cache::WriteVector(file, layout.layout.permutation);
+  return static_cast<bool>(file);
+}
+} // namespace detail
+} // namespace pcms
+
+#endif // PCMS_COUPLING_LAYOUT_CACHE_H
@@ -0,0 +1,126 @@
+#ifndef PCMS_COUPLING_MESSAGE_LAYOUT_H
+#define PCMS_COUPLING_MESSAGE_LAYOUT_H
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <redev.h>
+#include "pcms/types.h"
+#include "pcms/profile.h"
+
+namespace pcms
+{
+namespace detail
+{
+struct OutMsg
+{
+  redev::LOs dest;
+  redev::LOs offset;
+};
+
+// 64 bit FNV-1a hash of the gids. Used as a cheap fingerprint of the gids
+// that one rank sends to another during the layout exchange
+inline GO HashGids(const GO* gids, size_t n)
+{
+  PCMS_FUNCTION_TIMER;
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto hash_value = [&hash](std::uint64_t value) {
+    for (int byte = 0; byte < 8; ++byte) {
+      hash ^= (value >> (8 * byte)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  };
+  hash_value(n);
+  for (size_t i = 0; i < n; ++i) {
+    hash_value(static_cast<std::uint64_t>(gids[i]));
+  }
+  return static_cast<GO>(hash);
+}
+
+// identifies the message layout of a field by the gids of the local field
+// and the gids exchanged with each rank on the other side of the channel.
+// Two fields with the same key have the same layout and permutation
+struct MessageLayoutKey
+{
+  // hash of the gids of the local field
+  GO gid_hash = 0;
+  // ranks on the other side of the channel and the hash of the gids
+  // exchanged with each of them
+  redev::LOs sources;
+  std::vector<GO> checksums;
+
+  bool operator==(const MessageLayoutKey& other) const
+  {
+    return gid_hash == other.gid_hash && sources == other.sources &&
+           checksums == other.checksums;
+  }
+};
+
+// key of a layout. message_gids are the exchanged gids in message order,
+// split between the ranks by layout
+inline MessageLayoutKey MakeMessageLayoutKey(
+  const std::vector<GO>& local_gids, const OutMsg& layout,
+  const std::vector<GO>& message_gids)
+{
+  PCMS_FUNCTION_TIMER;
+  MessageLayoutKey key;
+  key.gid_hash = HashGids(local_gids.data(), local_gids.size());
+  key.sources = layout.dest;
+  key.checksums.reserve(layout.dest.size());
+  for (size_t i = 0; i < layout.dest.size(); ++i) {
+    const auto begin = layout.offset[i];
+    key.checksums.push_back(
+      HashGids(message_gids.data() + begin, layout.offset[i + 1] - begin));
+  }
+  return key;
+}
+
+// destination ranks and offsets of the messages of a field, and the
+// permutation from the field entries to the message entries
+struct MessageLayout
+{
+  OutMsg out_message;
+  std::vector<LO> permutation;
+};
+
+// layouts shared by the fields of an application. Fields with identical
+// partitions and gids reference the same layout instead of storing a copy
+class MessageLayoutRegistry
+{
+public:
+  [[nodiscard]] std::shared_ptr<const MessageLayout> Find(
+    const MessageLayoutKey& key) const
+  {
+    PCMS_FUNCTION_TIMER;
+    for (const auto& [layout_key, layout] : layouts_) {
+      if (layout_key == key) {
+        return layout;
+      }
+    }
+    return nullptr;
+  }
+  // returns the layout registered with key, or registers layout if there is
+  // none
+  std::shared_ptr<const MessageLayout> Insert(MessageLayoutKey key,
+                                              MessageLayout layout)
+  {
+    PCMS_FUNCTION_TIMER;
+    if (auto existing = Find(key)) {
+      return existing;
+    }
+    auto shared = std::make_shared<const MessageLayout>(std::move(layout));
+    layouts_.emplace_back(std::move(key), shared);
+    return shared;
+  }
+  [[nodiscard]] size_t size() const noexcept { return layouts_.size(); }
+
+private:
+  // only a handful of distinct layouts are expected, so a linear search is
+  // sufficient
+  std::vector<std::pair<MessageLayoutKey, std::shared_ptr<const MessageLayout>>>
+    layouts_;
+};
+} // namespace detail
+} // namespace pcms
+
+#endif // PCMS_COUPLING_MESSAGE_LAYOUT_H
@@ -521,14 +521,21 @@ public:
                   permutation) const
   {
     PCMS_FUNCTION_TIMER;
-    // host copy of filtered field data array
-    const auto array_h = Omega_h::HostRead<T>(get_nodal_data(field_));
-    if (buffer.size() > 0) {
-      for (LO i = 0; i < array_h.size(); i++) {
-        buffer[i] = array_h[permutation[i]];
-      }
+    // a size query does not need to filter or copy the data
+    if (buffer.size() == 0) {
+      return field_.Size();
     }
-    return array_h.size();
+    // the permutation is applied on the device, so only the packed values
+    // are copied to the host
+    const auto array = get_nodal_data(field_);
+    const LO n = array.size();
+    const auto permutation_d = CopyPermutationToDevice(permutation);
+    Kokkos::View<T*, memory_space> packed(
+      Kokkos::view_alloc(Kokkos::WithoutInitializing, "packed field"), n);
+    Omega_h::parallel_for(
+      n, OMEGA_H_LAMBDA(LO i) { packed(i) = array[permutation_d(i)]; });
+    Kokkos::deep_copy(HostView<T>(buffer.data_handle(), n), packed);
+    return n;
   }
   // REQUIRED
   void Deserialize(ScalarArrayView<const T, pcms::HostMemorySpace> buffer,
@@ -537,10 +544,15 @@ public:
   {
     PCMS_FUNCTION_TIMER;
     REDEV_ALWAYS_ASSERT(buffer.size() == permutation.size());
-    Omega_h::HostWrite<T> sorted_buffer(buffer.size());
-    for (size_t i = 0; i < buffer.size(); ++i) {
-      sorted_buffer[permutation[i]] = buffer[i];
-    }
+    const LO n = buffer.size();
+    const auto buffer_d = Kokkos::create_mirror_view_and_copy(
+      memory_space{}, HostView<const T>(buffer.data_handle(), n));
+    const auto permutation_d = CopyPermutationToDevice(permutation);
+    Omega_h::Write<T> sorted_buffer(n);
+    Omega_h::parallel_for(
+      n, OMEGA_H_LAMBDA(LO i) {
+        sorted_buffer[permutation_d(i)] = buffer_d(i);
+      });
     const auto sorted_buffer_d = Omega_h::Read<T>(sorted_buffer);
     set_nodal_data(field_, make_array_view(sorted_buffer_d));
   }
@@ -599,6 +611,18 @@ public:
   }
 
 private:
+  template <typename U>
+  using HostView =
+    Kokkos::View<U*, Kokkos::HostSpace, Kokkos::MemoryTraits<Kokkos::Unmanaged>>;
+
+  static auto CopyPermutationToDevice(
+    ScalarArrayView<const pcms::LO, pcms::HostMemorySpace> permutation)
+  {
+    return Kokkos::create_mirror_view_and_copy(
+      memory_space{},
+      HostView<const LO>(permutation.data_handle(), permutation.size()));
+  }
+
   OmegaHField<T, CoordinateElementType> field_;
   mesh_entity_type entity_type_;
 };
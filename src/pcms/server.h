@@ -4,6 +4,8 @@
 #include "pcms/field_communicator.h"
 #include "pcms/omega_h_field.h"
 #include "pcms/profile.h"
+#include <any>
+#include <functional>
 #include <map>
 #include <typeinfo>
 
@@ -55,7 +57,12 @@ public:
                           redev::Channel& channel, Omega_h::Mesh& internal_mesh,
                           TransferOptions native_to_internal,
                           TransferOptions internal_to_native,
-                          Omega_h::Read<Omega_h::I8> internal_field_mask)
+                          Omega_h::Read<Omega_h::I8> internal_field_mask,
+                          std::string layout_cache_directory = "",
+                          std::shared_ptr<detail::MessageLayoutRegistry>
+                            layout_registry = nullptr,
+                          WireEncoding wire_encoding = WireEncoding::Native,
+                          std::optional<double> delta_threshold = std::nullopt)
     : internal_field_{OmegaHField<typename FieldAdapterT::value_type,
                                   InternalCoordinateElement>(
         name + ".__internal__", internal_mesh, internal_field_mask, "", 10, 10, field_adapter.GetEntityType())}
@@ -64,7 +71,9 @@ public:
     coupled_field_ =
       std::make_unique<CoupledFieldModel<FieldAdapterT, FieldAdapterT>>(
         name, std::move(field_adapter), mpi_comm, redev, channel,
-        std::move(native_to_internal), std::move(internal_to_native));
+        std::move(native_to_internal), std::move(internal_to_native),
+        std::move(layout_cache_directory), std::move(layout_registry),
+        wire_encoding, delta_threshold);
   }
 
   void Send(Mode mode = Mode::Synchronous)
@@ -72,10 +81,28 @@ public:
     PCMS_FUNCTION_TIMER;
     coupled_field_->Send(mode);
   }
-  void Receive()
+  void Receive(Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
-    coupled_field_->Receive();
+    coupled_field_->Receive(mode);
+  }
+  // deserialize the field after a deferred receive once the receive phase
+  // ended
+  void FinishReceive()
+  {
+    PCMS_FUNCTION_TIMER;
+    coupled_field_->FinishReceive();
+  }
+  template <typename T>
+  [[nodiscard]] detail::MessagePacker<T>* GetMessagePacker()
+  {
+    PCMS_FUNCTION_TIMER;
+    auto packer = coupled_field_->GetMessagePacker();
+    if (auto* p = std::any_cast<detail::MessagePacker<T>*>(&packer)) {
+      return *p;
+    }
+    std::cerr << "Requested type does not match field value type\n";
+    std::abort();
   }
   void SyncNativeToInternal()
   {
@@ -111,7 +138,11 @@ public:
   struct CoupledFieldConcept
   {
     virtual void Send(Mode) = 0;
-    virtual void Receive() = 0;
+    virtual void Receive(Mode) = 0;
+    virtual void FinishReceive() = 0;
+    // message packer of the field communicator, or empty if the field is not
+    // communicated
+    [[nodiscard]] virtual std::any GetMessagePacker() noexcept = 0;
     virtual void SyncNativeToInternal(InternalField&) = 0;
     virtual void SyncInternalToNative(const InternalField&) = 0;
     [[nodiscard]] virtual const std::type_info& GetFieldAdapterType()
@@ -140,10 +171,17 @@ public:
                       MPI_Comm mpi_comm, redev::Redev& redev,
                       redev::Channel& channel,
                       TransferOptions&& native_to_internal,
-                      TransferOptions&& internal_to_native)
+                      TransferOptions&& internal_to_native,
+                      std::string layout_cache_directory,
+                      std::shared_ptr<detail::MessageLayoutRegistry>
+                        layout_registry,
+                      WireEncoding wire_encoding,
+                      std::optional<double> delta_threshold)
       : field_adapter_(std::move(field_adapter)),
-        comm_(FieldCommunicator<FieldAdapterT>(name, mpi_comm, redev, channel,
-                                               field_adapter_)),
+        comm_(FieldCommunicator<FieldAdapterT>(
+          name, mpi_comm, redev, channel, field_adapter_,
+          std::move(layout_cache_directory), std::move(layout_registry),
+          wire_encoding, delta_threshold)),
         native_to_internal_(std::move(native_to_internal)),
         internal_to_native_(std::move(internal_to_native)),
         type_info_(typeid(FieldAdapterT))
@@ -155,11 +193,25 @@ public:
       PCMS_FUNCTION_TIMER;
       comm_.Send(mode);
     };
-    void Receive() final
+    void Receive(Mode mode) final
     {
       PCMS_FUNCTION_TIMER;
-      comm_.Receive();
+      comm_.Receive(mode);
     };
+    void FinishReceive() final
+    {
+      PCMS_FUNCTION_TIMER;
+      comm_.FinishReceive();
+    };
+    std::any GetMessagePacker() noexcept final
+    {
+      using Packer = detail::MessagePacker<value_type>;
+      if constexpr (std::is_base_of_v<Packer, FieldCommunicator<CommT>>) {
+        return static_cast<Packer*>(&comm_);
+      } else {
+        return {};
+      }
+    }
     void SyncNativeToInternal(InternalField& internal_field) final
     {
       PCMS_FUNCTION_TIMER;
@@ -214,8 +266,17 @@ public:
   {
     PCMS_FUNCTION_TIMER;
   }
+  // fields added after this call cache their message layouts in directory
+  // and reuse them when the clients present the same gids on the next start.
+  // The clients must enable the layout cache as well
+  void EnableLayoutCache(std::string directory)
+  {
+    layout_cache_directory_ = std::move(directory);
+  }
   // FIXME should take a file path for the parameters, not take adios2 params.
   // These fields are supposed to be agnostic to adios2...
+  // wire_encoding and delta_threshold must match the options the client uses
+  // for the field
   template <typename FieldAdapterT>
   ConvertibleCoupledField* AddField(
     std::string name, FieldAdapterT&& field_adapter,
@@ -223,7 +284,9 @@ public:
     FieldEvaluationMethod to_field_eval_method,
     FieldTransferMethod from_field_transfer_method,
     FieldEvaluationMethod from_field_eval_method,
-    Omega_h::Read<Omega_h::I8> internal_field_mask = {})
+    Omega_h::Read<Omega_h::I8> internal_field_mask = {},
+    WireEncoding wire_encoding = WireEncoding::Native,
+    std::optional<double> delta_threshold = std::nullopt)
   {
     PCMS_FUNCTION_TIMER;
     auto [it, inserted] = fields_.template try_emplace(
@@ -231,7 +294,8 @@ public:
       channel_, internal_mesh_,
       TransferOptions{to_field_transfer_method, to_field_eval_method},
       TransferOptions{from_field_transfer_method, from_field_eval_method},
-      internal_field_mask);
+      internal_field_mask, layout_cache_directory_, layout_registry_,
+      wire_encoding, delta_threshold);
     if (!inserted) {
       std::cerr << "OHField with this name" << name << "already exists!\n";
       std::terminate();
@@ -244,11 +308,55 @@ public:
     PCMS_ALWAYS_ASSERT(InSendPhase());
     detail::find_or_error(name, fields_).Send(mode);
   };
-  void ReceiveField(const std::string& name)
+  // with Mode::Deferred the field is deserialized when the receive phase
+  // ends, so several fields can be received before any of them is processed
+  void ReceiveField(const std::string& name, Mode mode = Mode::Synchronous)
   {
     PCMS_FUNCTION_TIMER;
     PCMS_ALWAYS_ASSERT(InReceivePhase());
-    detail::find_or_error(name, fields_).Receive();
+    auto& field = detail::find_or_error(name, fields_);
+    field.Receive(mode);
+    if (mode == Mode::Deferred) {
+      deferred_receives_.emplace_back([&field]() { field.FinishReceive(); });
+    }
+  };
+  // fields in a group are sent and received as one message per destination
+  // rank, so all of them must have the same partition and value type
+  template <typename T = Real>
+  FieldGroup* AddFieldGroup(const std::string& name,
+                            const std::vector<std::string>& field_names)
+  {
+    PCMS_FUNCTION_TIMER;
+    std::vector<detail::MessagePacker<T>*> packers;
+    packers.reserve(field_names.size());
+    for (const auto& field_name : field_names) {
+      auto& field = detail::find_or_error(field_name, fields_);
+      packers.push_back(field.template GetMessagePacker<T>());
+    }
+    auto [it, inserted] = field_groups_.try_emplace(
+      name, std::in_place_type<T>, name, channel_, std::move(packers));
+    if (!inserted) {
+      std::cerr << "FieldGroup with this name" << name << "already exists!\n";
+      std::terminate();
+    }
+    return &(it->second);
+  }
+  void SendFieldGroup(const std::string& name, Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(InSendPhase());
+    detail::find_or_error(name, field_groups_).Send(mode);
+  };
+  void ReceiveFieldGroup(const std::string& name,
+                         Mode mode = Mode::Synchronous)
+  {
+    PCMS_FUNCTION_TIMER;
+    PCMS_ALWAYS_ASSERT(InReceivePhase());
+    auto& group = detail::find_or_error(name, field_groups_);
+    group.Receive(mode);
+    if (mode == Mode::Deferred) {
+      deferred_receives_.emplace_back([&group]() { group.FinishReceive(); });
+    }
   };
   [[nodiscard]] bool InSendPhase() const noexcept
   {
@@ -279,6 +387,7 @@ public:
   {
     PCMS_FUNCTION_TIMER;
     channel_.EndReceiveCommunicationPhase();
+    FinishDeferredReceives();
   }
 
   template <typename Func, typename... Args>
@@ -291,10 +400,26 @@ public:
   auto ReceivePhase(const Func& func, Args&&... args)
   {
     PCMS_FUNCTION_TIMER;
+    // deferred receives are deserialized after the phase ended and the result
+    // of func was constructed
+    struct DeferredReceiveGuard
+    {
+      Application& application;
+      ~DeferredReceiveGuard() { application.FinishDeferredReceives(); }
+    } guard{*this};
     return channel_.ReceivePhase(func, std::forward<Args>(args)...);
   }
 
 private:
+  void FinishDeferredReceives()
+  {
+    PCMS_FUNCTION_TIMER;
+    for (auto& finish_receive : deferred_receives_) {
+      finish_receive();
+    }
+    deferred_receives_.clear();
+  }
+
   MPI_Comm mpi_comm_;
   redev::Redev& redev_;
   redev::Channel channel_;
@@ -302,6 +427,15 @@ private:
   // internal data and rehash of unordered_map can cause pointer invalidation.
   // map is less cache friendly, but pointers are not invalidated.
   std::map<std::string, ConvertibleCoupledField> fields_;
+  std::string layout_cache_directory_;
+  // layouts shared by the fields with the same gids and partition
+  std::shared_ptr<detail::MessageLayoutRegistry> layout_registry_ =
+    std::make_shared<detail::MessageLayoutRegistry>();
+  // field groups refer to the fields, so they are declared after them to be
+  // destroyed first
+  std::map<std::string, FieldGroup> field_groups_;
+  // deserialization of the fields received with Mode::Deferred
+  std::vector<std::function<void()>> deferred_receives_;
   Omega_h::Mesh& internal_mesh_;
 };
 class GatherOperation
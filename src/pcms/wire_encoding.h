@@ -0,0 +1,111 @@
+#ifndef PCMS_COUPLING_WIRE_ENCODING_H
+#define PCMS_COUPLING_WIRE_ENCODING_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "pcms/assert.h"
+#include "pcms/message_layout.h"
+#include "pcms/profile.h"
+
+namespace pcms
+{
+// encoding of the field values in the messages between applications
+enum class WireEncoding
+{
+  // values are sent in the value_type of the field adapter
+  Native,
+  // values are sent as single precision floats
+  Float32,
+  // values are quantized to 16 bits over the range of each message. The
+  // error of each value is at most 1/131070 of the range of its message.
+  // The values must be finite
+  Quantized16
+};
+
+namespace detail
+{
+using QuantizedValue = std::uint16_t;
+constexpr QuantizedValue max_quantized_value = 65535;
+// the minimum and step of a quantized message are stored as doubles in
+// the message header
+constexpr int quantized_header_size =
+  2 * sizeof(double) / sizeof(QuantizedValue);
+
+// offsets of the quantized messages, which have a header in front of the
+// values of each message
+inline redev::LOs QuantizedMessageOffsets(const OutMsg& layout)
+{
+  redev::LOs offset(layout.offset.size());
+  for (size_t r = 0; r < offset.size(); ++r) {
+    offset[r] = layout.offset[r] + r * quantized_header_size;
+  }
+  return offset;
+}
+
+template <typename T>
+void QuantizeMessages(const OutMsg& layout, const T* values,
+                      std::vector<QuantizedValue>& quantized)
+{
+  PCMS_FUNCTION_TIMER;
+  const auto offset = QuantizedMessageOffsets(layout);
+  quantized.resize(offset.back());
+  for (size_t r = 0; r + 1 < layout.offset.size(); ++r) {
+    const T* message = values + layout.offset[r];
+    const auto n = layout.offset[r + 1] - layout.offset[r];
+    auto* out = quantized.data() + offset[r];
+    double min = 0;
+    double step = 0;
+    if (n > 0) {
+      // rounding a NaN or infinite value is undefined, so such a field can
+      // not be quantized
+      PCMS_ALWAYS_ASSERT(std::all_of(message, message + n, [](T value) {
+        return std::isfinite(static_cast<double>(value));
+      }));
+      const auto [min_it, max_it] = std::minmax_element(message, message + n);
+      min = *min_it;
+      step = (static_cast<double>(*max_it) - min) / max_quantized_value;
+      // the range of values near the limits of double overflows
+      PCMS_ALWAYS_ASSERT(std::isfinite(step));
+    }
+    std::memcpy(out, &min, sizeof(double));
+    std::memcpy(out + quantized_header_size / 2, &step, sizeof(double));
+    out += quantized_header_size;
+    for (LO i = 0; i < n; ++i) {
+      const double level =
+        step > 0 ? std::min((message[i] - min) / step,
+                            static_cast<double>(max_quantized_value))
+                 : 0;
+      out[i] = static_cast<QuantizedValue>(std::lround(level));
+    }
+  }
+}
+
+template <typename T>
+void DequantizeMessages(const OutMsg& layout,
+                        const std::vector<QuantizedValue>& quantized,
+                        T* values)
+{
+  PCMS_FUNCTION_TIMER;
+  const auto offset = QuantizedMessageOffsets(layout);
+  REDEV_ALWAYS_ASSERT(quantized.size() == static_cast<size_t>(offset.back()));
+  for (size_t r = 0; r + 1 < layout.offset.size(); ++r) {
+    const auto* in = quantized.data() + offset[r];
+    const auto n = layout.offset[r + 1] - layout.offset[r];
+    T* message = values + layout.offset[r];
+    double min;
+    double step;
+    std::memcpy(&min, in, sizeof(double));
+    std::memcpy(&step, in + quantized_header_size / 2, sizeof(double));
+    PCMS_ALWAYS_ASSERT(std::isfinite(min) && std::isfinite(step));
+    in += quantized_header_size;
+    for (LO i = 0; i < n; ++i) {
+      message[i] = static_cast<T>(min + step * in[i]);
+    }
+  }
+}
+} // namespace detail
+} // namespace pcms
+
+#endif // PCMS_COUPLING_WIRE_ENCODING_H
@@ -0,0 +1,407 @@
+#include <Omega_h_mesh.hpp>
+#include <iostream>
+#include <pcms.h>
+#include <pcms/types.h>
+#include <Omega_h_file.hpp>
+#include <Omega_h_for.hpp>
+#include <redev_variant_tools.h>
+#include "test_support.h"
+#include <pcms/omega_h_field.h>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+using pcms::CouplerClient;
+using pcms::CouplerServer;
+using pcms::FieldEvaluationMethod;
+using pcms::FieldTransferMethod;
+using pcms::GO;
+using pcms::LO;
+using pcms::OmegaHFieldAdapter;
+using pcms::Real;
+
+namespace ts = test_support;
+
+static const std::string layout_cache_directory = "coupling_options_layouts";
+
+// each stage couples a client and a server application with the same name,
+// so the stages must run in the same order on both sides
+
+// sets the vertex tag name to scale * gid + shift
+void set_values(Omega_h::Mesh& mesh, const std::string& name, Real scale,
+                Real shift)
+{
+  const auto gids = mesh.globals(0);
+  Omega_h::Write<Real> values(mesh.nverts());
+  Omega_h::parallel_for(
+    mesh.nverts(),
+    OMEGA_H_LAMBDA(LO i) { values[i] = scale * gids[i] + shift; });
+  if (mesh.has_tag(0, name)) {
+    mesh.set_tag(0, name, Omega_h::Reals(values));
+  } else {
+    mesh.add_tag(0, name, 1, Omega_h::Reals(values));
+  }
+}
+// checks that the vertices in the mask hold scale * gid + shift in the tag
+// name
+void check_values(Omega_h::Mesh& mesh, Omega_h::Read<Omega_h::I8> mask,
+                  const std::string& name, Real scale, Real shift)
+{
+  const auto gids = Omega_h::HostRead<GO>(mesh.globals(0));
+  const auto values = Omega_h::HostRead<Real>(mesh.get_array<Real>(0, name));
+  const auto mask_h = Omega_h::HostRead<Omega_h::I8>(mask);
+  for (LO i = 0; i < mesh.nverts(); ++i) {
+    if (mask_h[i]) {
+      REDEV_ALWAYS_ASSERT(std::abs(values[i] - (scale * gids[i] + shift)) <
+                          1E-9);
+    }
+  }
+}
+
+// the fields of a group travel in one message per rank and must all arrive
+// in their own tags
+void field_group_client(MPI_Comm comm, Omega_h::Mesh& mesh,
+                        Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  CouplerClient cpl("coupling_options_field_group", comm);
+  set_values(mesh, "density", 1, 0);
+  set_values(mesh, "temperature", 2, 0.5);
+  cpl.AddField("density", OmegaHFieldAdapter<Real>("density", mesh, is_overlap));
+  cpl.AddField("temperature",
+               OmegaHFieldAdapter<Real>("temperature", mesh, is_overlap));
+  cpl.AddFieldGroup<Real>("plasma", {"density", "temperature"});
+  cpl.BeginSendPhase();
+  cpl.SendFieldGroup("plasma");
+  cpl.EndSendPhase();
+  cpl.BeginReceivePhase();
+  cpl.ReceiveFieldGroup("plasma");
+  cpl.EndReceivePhase();
+  check_values(mesh, is_overlap, "density", 3, 1);
+  check_values(mesh, is_overlap, "temperature", 4, 2);
+}
+void field_group_server(CouplerServer& cpl, Omega_h::Mesh& mesh,
+                        Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  auto* app = cpl.AddApplication("coupling_options_field_group");
+  app->AddField("density",
+                OmegaHFieldAdapter<Real>("group_density", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap);
+  app->AddField("temperature",
+                OmegaHFieldAdapter<Real>("group_temperature", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap);
+  app->AddFieldGroup<Real>("plasma", {"density", "temperature"});
+  app->ReceivePhase([&]() { app->ReceiveFieldGroup("plasma"); });
+  check_values(mesh, is_overlap, "group_density", 1, 0);
+  check_values(mesh, is_overlap, "group_temperature", 2, 0.5);
+  set_values(mesh, "group_density", 3, 1);
+  set_values(mesh, "group_temperature", 4, 2);
+  app->SendPhase([&]() { app->SendFieldGroup("plasma"); });
+}
+
+// deferred receives only fill in the fields once the receive phase ended,
+// either in EndReceivePhase or when the ReceivePhase function returns
+void deferred_receive_client(MPI_Comm comm, Omega_h::Mesh& mesh,
+                             Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  CouplerClient cpl("coupling_options_deferred_receive", comm);
+  set_values(mesh, "flux", 1, 0);
+  set_values(mesh, "source", 2, 0);
+  cpl.AddField("flux", OmegaHFieldAdapter<Real>("flux", mesh, is_overlap));
+  cpl.AddField("source", OmegaHFieldAdapter<Real>("source", mesh, is_overlap));
+  cpl.AddFieldGroup<Real>("flux_source", {"flux", "source"});
+
+  cpl.BeginSendPhase();
+  cpl.SendField("flux");
+  cpl.SendField("source");
+  cpl.EndSendPhase();
+  cpl.BeginReceivePhase();
+  cpl.ReceiveField("flux", pcms::Mode::Deferred);
+  cpl.ReceiveField("source", pcms::Mode::Deferred);
+  check_values(mesh, is_overlap, "flux", 1, 0);
+  check_values(mesh, is_overlap, "source", 2, 0);
+  cpl.EndReceivePhase();
+  check_values(mesh, is_overlap, "flux", 5, 1);
+  check_values(mesh, is_overlap, "source", 6, 1);
+
+  cpl.BeginSendPhase();
+  cpl.SendFieldGroup("flux_source");
+  cpl.EndSendPhase();
+  cpl.BeginReceivePhase();
+  cpl.ReceiveFieldGroup("flux_source", pcms::Mode::Deferred);
+  check_values(mesh, is_overlap, "flux", 5, 1);
+  check_values(mesh, is_overlap, "source", 6, 1);
+  cpl.EndReceivePhase();
+  check_values(mesh, is_overlap, "flux", 7, 2);
+  check_values(mesh, is_overlap, "source", 8, 2);
+}
+void deferred_receive_server(CouplerServer& cpl, Omega_h::Mesh& mesh,
+                             Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  auto* app = cpl.AddApplication("coupling_options_deferred_receive");
+  app->AddField("flux",
+                OmegaHFieldAdapter<Real>("deferred_flux", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap);
+  app->AddField("source",
+                OmegaHFieldAdapter<Real>("deferred_source", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap);
+  app->AddFieldGroup<Real>("flux_source", {"flux", "source"});
+
+  app->ReceivePhase([&]() {
+    app->ReceiveField("flux", pcms::Mode::Deferred);
+    app->ReceiveField("source", pcms::Mode::Deferred);
+  });
+  check_values(mesh, is_overlap, "deferred_flux", 1, 0);
+  check_values(mesh, is_overlap, "deferred_source", 2, 0);
+  set_values(mesh, "deferred_flux", 5, 1);
+  set_values(mesh, "deferred_source", 6, 1);
+  app->SendPhase([&]() {
+    app->SendField("flux");
+    app->SendField("source");
+  });
+
+  app->ReceivePhase(
+    [&]() { app->ReceiveFieldGroup("flux_source", pcms::Mode::Deferred); });
+  check_values(mesh, is_overlap, "deferred_flux", 5, 1);
+  check_values(mesh, is_overlap, "deferred_source", 6, 1);
+  set_values(mesh, "deferred_flux", 7, 2);
+  set_values(mesh, "deferred_source", 8, 2);
+  app->SendPhase([&]() { app->SendFieldGroup("flux_source"); });
+}
+
+// one start of an application that caches the layout of its field. The
+// client only takes part in the handshake, so all checks of the cache are on
+// the server
+void layout_cache_client(MPI_Comm comm, Omega_h::Mesh& mesh,
+                         Omega_h::Read<Omega_h::I8> is_overlap,
+                         const std::string& name, Real shift)
+{
+  CouplerClient cpl(name, comm);
+  cpl.EnableLayoutCache(layout_cache_directory);
+  set_values(mesh, "cached", 1, shift);
+  cpl.AddField("cached", OmegaHFieldAdapter<Real>("cached", mesh, is_overlap));
+  cpl.BeginSendPhase();
+  cpl.SendField("cached");
+  cpl.EndSendPhase();
+  cpl.BeginReceivePhase();
+  cpl.ReceiveField("cached");
+  cpl.EndReceivePhase();
+  check_values(mesh, is_overlap, "cached", 2, shift);
+}
+void layout_cache_server(CouplerServer& cpl, Omega_h::Mesh& mesh,
+                         Omega_h::Read<Omega_h::I8> is_overlap,
+                         const std::string& name, Real shift)
+{
+  auto* app = cpl.AddApplication(name);
+  app->EnableLayoutCache(layout_cache_directory);
+  app->AddField("cached",
+                OmegaHFieldAdapter<Real>("server_cached", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap);
+  app->ReceivePhase([&]() { app->ReceiveField("cached"); });
+  check_values(mesh, is_overlap, "server_cached", 1, shift);
+  set_values(mesh, "server_cached", 2, shift);
+  app->SendPhase([&]() { app->SendField("cached"); });
+}
+// the first start writes the cache, the second start uses it without
+// writing it again, and a start with a stale cache rebuilds it
+void layout_cache_client_restarts(MPI_Comm comm, Omega_h::Mesh& mesh,
+                                  Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  layout_cache_client(comm, mesh, is_overlap,
+                      "coupling_options_layout_cache_cold", 0);
+  layout_cache_client(comm, mesh, is_overlap,
+                      "coupling_options_layout_cache_hit", 1);
+  layout_cache_client(comm, mesh, is_overlap,
+                      "coupling_options_layout_cache_stale", 2);
+}
+void layout_cache_server_restarts(MPI_Comm comm, CouplerServer& cpl,
+                                  Omega_h::Mesh& mesh,
+                                  Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  if (!rank) {
+    std::filesystem::remove_all(layout_cache_directory);
+    std::filesystem::create_directories(layout_cache_directory);
+  }
+  MPI_Barrier(comm);
+  const auto path =
+    pcms::detail::LayoutCachePath(layout_cache_directory, "cached", rank);
+
+  layout_cache_server(cpl, mesh, is_overlap,
+                      "coupling_options_layout_cache_cold", 0);
+  pcms::detail::CachedLayout written;
+  REDEV_ALWAYS_ASSERT(pcms::detail::ReadLayoutCache(path, written));
+
+  const auto write_time =
+    std::filesystem::last_write_time(path) - std::chrono::hours(1);
+  std::filesystem::last_write_time(path, write_time);
+  layout_cache_server(cpl, mesh, is_overlap,
+                      "coupling_options_layout_cache_hit", 1);
+  REDEV_ALWAYS_ASSERT(std::filesystem::last_write_time(path) == write_time);
+
+  // a cache of other gids, e.g. of a previous mesh
+  auto stale = written;
+  stale.key.gid_hash += 1;
+  REDEV_ALWAYS_ASSERT(pcms::detail::WriteLayoutCache(path, stale));
+  layout_cache_server(cpl, mesh, is_overlap,
+                      "coupling_options_layout_cache_stale", 2);
+  pcms::detail::CachedLayout rewritten;
+  REDEV_ALWAYS_ASSERT(pcms::detail::ReadLayoutCache(path, rewritten));
+  REDEV_ALWAYS_ASSERT(rewritten.key.gid_hash == written.key.gid_hash);
+  REDEV_ALWAYS_ASSERT(rewritten.layout.permutation ==
+                      written.layout.permutation);
+}
+
+// fields with the same gids and partition share one message layout through
+// the layout registry of the client and of the server application
+void layout_registry_client(MPI_Comm comm, Omega_h::Mesh& mesh,
+                            Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  CouplerClient cpl("coupling_options_layout_registry", comm);
+  set_values(mesh, "ion_density", 1, 0);
+  set_values(mesh, "electron_density", 2, 0);
+  auto* ions = cpl.AddField(
+    "ion_density", OmegaHFieldAdapter<Real>("ion_density", mesh, is_overlap));
+  auto* electrons = cpl.AddField(
+    "electron_density",
+    OmegaHFieldAdapter<Real>("electron_density", mesh, is_overlap));
+  REDEV_ALWAYS_ASSERT(&ions->GetMessagePacker<Real>()->GetMessageLayout() ==
+                      &electrons->GetMessagePacker<Real>()->GetMessageLayout());
+  cpl.BeginSendPhase();
+  cpl.SendField("ion_density");
+  cpl.SendField("electron_density");
+  cpl.EndSendPhase();
+  cpl.BeginReceivePhase();
+  cpl.ReceiveField("ion_density");
+  cpl.ReceiveField("electron_density");
+  cpl.EndReceivePhase();
+  check_values(mesh, is_overlap, "ion_density", 3, 1);
+  check_values(mesh, is_overlap, "electron_density", 4, 1);
+}
+void layout_registry_server(CouplerServer& cpl, Omega_h::Mesh& mesh,
+                            Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  auto* app = cpl.AddApplication("coupling_options_layout_registry");
+  auto* ions = app->AddField(
+    "ion_density", OmegaHFieldAdapter<Real>("shared_ions", mesh, is_overlap),
+    FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+    FieldTransferMethod::Copy, FieldEvaluationMethod::None, is_overlap);
+  auto* electrons = app->AddField(
+    "electron_density",
+    OmegaHFieldAdapter<Real>("shared_electrons", mesh, is_overlap),
+    FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+    FieldTransferMethod::Copy, FieldEvaluationMethod::None, is_overlap);
+  REDEV_ALWAYS_ASSERT(&ions->GetMessagePacker<Real>()->GetMessageLayout() ==
+                      &electrons->GetMessagePacker<Real>()->GetMessageLayout());
+  app->ReceivePhase([&]() {
+    app->ReceiveField("ion_density");
+    app->ReceiveField("electron_density");
+  });
+  check_values(mesh, is_overlap, "shared_ions", 1, 0);
+  check_values(mesh, is_overlap, "shared_electrons", 2, 0);
+  set_values(mesh, "shared_ions", 3, 1);
+  set_values(mesh, "shared_electrons", 4, 1);
+  app->SendPhase([&]() {
+    app->SendField("ion_density");
+    app->SendField("electron_density");
+  });
+}
+
+// a field that changed by less than the delta threshold is not sent and the
+// server keeps the values it received last
+static constexpr Real delta_threshold = 1E-3;
+void delta_transfer_client(MPI_Comm comm, Omega_h::Mesh& mesh,
+                           Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  CouplerClient cpl("coupling_options_delta_transfer", comm);
+  cpl.AddField("potential",
+               OmegaHFieldAdapter<Real>("potential", mesh, is_overlap), true,
+               pcms::WireEncoding::Native, delta_threshold);
+  for (Real shift : {0.0, 1E-6, 1.0}) {
+    set_values(mesh, "potential", 1, shift);
+    cpl.BeginSendPhase();
+    cpl.SendField("potential");
+    cpl.EndSendPhase();
+  }
+}
+void delta_transfer_server(CouplerServer& cpl, Omega_h::Mesh& mesh,
+                           Omega_h::Read<Omega_h::I8> is_overlap)
+{
+  auto* app = cpl.AddApplication("coupling_options_delta_transfer");
+  app->AddField("potential",
+                OmegaHFieldAdapter<Real>("delta_potential", mesh, is_overlap),
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                FieldTransferMethod::Copy, FieldEvaluationMethod::None,
+                is_overlap, pcms::WireEncoding::Native, delta_threshold);
+  // the second step is below the threshold, so the first values are kept
+  for (Real shift : {0.0, 0.0, 1.0}) {
+    app->ReceivePhase([&]() { app->ReceiveField("potential"); });
+    check_values(mesh, is_overlap, "delta_potential", 1, shift);
+  }
+}
+
+void coupling_options_client(MPI_Comm comm, Omega_h::Mesh& mesh)
+{
+  auto is_overlap = ts::markOverlapMeshEntities(mesh, ts::IsModelEntInOverlap{});
+  field_group_client(comm, mesh, is_overlap);
+  deferred_receive_client(comm, mesh, is_overlap);
+  layout_cache_client_restarts(comm, mesh, is_overlap);
+  layout_registry_client(comm, mesh, is_overlap);
+  delta_transfer_client(comm, mesh, is_overlap);
+}
+void coupling_options_server(MPI_Comm comm, Omega_h::Mesh& mesh,
+                             std::string_view cpn_file)
+{
+  pcms::CouplerServer cpl(
+    "coupling_options", comm,
+    redev::Partition{ts::setupServerPartition(mesh, cpn_file)}, mesh);
+  const auto partition = std::get<redev::ClassPtn>(cpl.GetPartition());
+  auto is_overlap =
+    ts::markServerOverlapRegion(mesh, partition, ts::IsModelEntInOverlap{});
+  field_group_server(cpl, mesh, is_overlap);
+  deferred_receive_server(cpl, mesh, is_overlap);
+  layout_cache_server_restarts(comm, cpl, mesh, is_overlap);
+  layout_registry_server(cpl, mesh, is_overlap);
+  delta_transfer_server(cpl, mesh, is_overlap);
+}
+
+int main(int argc, char** argv)
+{
+  auto lib = Omega_h::Library(&argc, &argv);
+  auto world = lib.world();
+  const int rank = world->rank();
+  if (argc != 4) {
+    if (!rank) {
+      std::cerr << "Usage: " << argv[0]
+                << " <clientId=-1|0> /path/to/omega_h/mesh "
+                   "/path/to/partitionFile.cpn\n";
+    }
+    exit(EXIT_FAILURE);
+  }
+  OMEGA_H_CHECK(argc == 4);
+  const auto clientId = atoi(argv[1]);
+  REDEV_ALWAYS_ASSERT(clientId >= -1 && clientId <= 0);
+  const auto meshFile = argv[2];
+  const auto classPartitionFile = argv[3];
+  Omega_h::Mesh mesh(&lib);
+  Omega_h::binary::read(meshFile, lib.world(), &mesh);
+  MPI_Comm mpi_comm = lib.world()->get_impl();
+  switch (clientId) {
+    case -1: coupling_options_server(mpi_comm, mesh, classPartitionFile); break;
+    case 0: coupling_options_client(mpi_comm, mesh); break;
+    default:
+      std::cerr << "Unhandled client id (should be -1, 0)\n";
+      exit(EXIT_FAILURE);
+  }
+  return 0;
+}
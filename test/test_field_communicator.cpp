@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pcms/field_communicator.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+using pcms::GO;
+
+TEST_CASE("permutation from received gids")
+{
+  SECTION("small")
+  {
+    std::vector<GO> local_gids{10, 20, 30, 40};
+    std::vector<GO> received_gids{30, 10, 40, 20};
+    auto permutation =
+      pcms::detail::ConstructPermutation(local_gids, received_gids);
+    REQUIRE(permutation == redev::LOs{2, 0, 3, 1});
+  }
+  SECTION("shuffled")
+  {
+    std::vector<GO> local_gids(10000);
+    std::iota(local_gids.begin(), local_gids.end(), 1);
+    auto received_gids = local_gids;
+    std::shuffle(received_gids.begin(), received_gids.end(),
+                 std::mt19937{42});
+    auto permutation =
+      pcms::detail::ConstructPermutation(local_gids, received_gids);
+    REQUIRE(permutation.size() == received_gids.size());
+    for (size_t i = 0; i < received_gids.size(); ++i) {
+      REQUIRE(local_gids[permutation[i]] == received_gids[i]);
+    }
+  }
+  SECTION("empty")
+  {
+    auto permutation = pcms::detail::ConstructPermutation({}, {});
+    REQUIRE(permutation.empty());
+  }
+}
+
+TEST_CASE("fields with the same gids and partition share a layout")
+{
+  std::vector<GO> gids{1, 2, 3, 4, 5};
+  pcms::detail::OutMsg out_message{{0, 1}, {0, 2, 5}};
+  std::vector<GO> message_gids{4, 2, 1, 5, 3};
+  auto key = pcms::detail::MakeMessageLayoutKey(gids, out_message,
+                                                message_gids);
+  REQUIRE(key.sources == redev::LOs{0, 1});
+  REQUIRE(key.checksums.size() == 2);
+
+  pcms::detail::MessageLayoutRegistry registry;
+  auto layout = registry.Insert(key, {out_message, {2, 1, 4, 0, 3}});
+  auto same_layout = registry.Insert(key, {out_message, {2, 1, 4, 0, 3}});
+  REQUIRE(layout == same_layout);
+  REQUIRE(registry.size() == 1);
+
+  std::vector<GO> other_message_gids{2, 4, 1, 5, 3};
+  auto other_key = pcms::detail::MakeMessageLayoutKey(gids, out_message,
+                                                      other_message_gids);
+  REQUIRE(registry.Find(other_key) == nullptr);
+  auto other_layout =
+    registry.Insert(other_key, {out_message, {2, 0, 4, 1, 3}});
+  REQUIRE(other_layout != layout);
+  REQUIRE(registry.size() == 2);
+}
+
+TEST_CASE("gid messages are range encoded")
+{
+  using pcms::detail::DecodeGidMessages;
+  using pcms::detail::EncodeGidMessages;
+  pcms::detail::OutMsg layout{{0, 2, 3}, {0, 6, 10, 11}};
+  // contiguous ranges, scattered gids and a single gid
+  std::vector<GO> gid_msgs{1, 2, 3, 4, 10, 11, 7, 3, 9, 5, 42};
+  auto encoded = EncodeGidMessages(layout, gid_msgs);
+  REQUIRE(encoded.offset == redev::LOs{0, 6, 12, 15});
+  // two ranges for the first rank
+  REQUIRE(encoded.data[1] == 2);
+  // raw gids for the second rank
+  REQUIRE(encoded.data[7] == pcms::detail::raw_gids);
+
+  pcms::detail::OutMsg encoded_layout{layout.dest, encoded.offset};
+  auto [decoded_layout, gids] = DecodeGidMessages(encoded_layout, encoded.data);
+  REQUIRE(decoded_layout.dest == layout.dest);
+  REQUIRE(decoded_layout.offset == layout.offset);
+  REQUIRE(gids == gid_msgs);
+}
+
+TEST_CASE("contiguous gids encode to a single range")
+{
+  pcms::detail::OutMsg layout{{0}, {0, 100000}};
+  std::vector<GO> gid_msgs(100000);
+  std::iota(gid_msgs.begin(), gid_msgs.end(), 1);
+  auto encoded = pcms::detail::EncodeGidMessages(layout, gid_msgs);
+  REQUIRE(encoded.data == std::vector<GO>{100000, 1, 1, 100000});
+  auto decoded = pcms::detail::DecodeGidMessages({{0}, encoded.offset},
+                                                 encoded.data);
+  REQUIRE(decoded.second == gid_msgs);
+}
+
+TEST_CASE("quantized messages stay within the error bound")
+{
+  pcms::detail::OutMsg layout{{0, 1, 2}, {0, 1000, 1000, 1003}};
+  std::vector<double> values(1003);
+  for (size_t i = 0; i < 1000; ++i) {
+    values[i] = std::sin(0.01 * i) * 1e3;
+  }
+  values[1000] = values[1001] = values[1002] = 42.0;
+  std::vector<pcms::detail::QuantizedValue> quantized;
+  pcms::detail::QuantizeMessages(layout, values.data(), quantized);
+  REQUIRE(quantized.size() ==
+          values.size() + 3 * pcms::detail::quantized_header_size);
+
+  std::vector<double> decoded(values.size());
+  pcms::detail::DequantizeMessages(layout, quantized, decoded.data());
+  const double range = 2e3;
+  for (size_t i = 0; i < 1000; ++i) {
+    REQUIRE(std::abs(decoded[i] - values[i]) <= range / 131070 * (1 + 1e-9));
+  }
+  // a constant message is exact
+  for (size_t i = 1000; i < 1003; ++i) {
+    REQUIRE(decoded[i] == 42.0);
+  }
+}
+
+TEST_CASE("delta transfers detect changed messages")
+{
+  using pcms::detail::MessageChanged;
+  std::vector<double> snapshot{1.0, 2.0, 3.0};
+  std::vector<double> values = snapshot;
+  REQUIRE_FALSE(MessageChanged(values, snapshot, 0.0));
+  values[1] = 2.05;
+  REQUIRE(MessageChanged(values, snapshot, 0.0));
+  REQUIRE(MessageChanged(values, snapshot, 0.01));
+  REQUIRE_FALSE(MessageChanged(values, snapshot, 0.1));
+  values[2] = std::nan("");
+  REQUIRE(MessageChanged(values, snapshot, 0.1));
+}
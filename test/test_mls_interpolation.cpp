@@ -0,0 +1,278 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <MLSInterpolation.hpp>
+#include <grid_search.hpp>
+#include <Omega_h_library.hpp>
+#include <random>
+#include <vector>
+
+// points of an n x n lattice over the unit square, each moved randomly by up
+// to a fifth of the lattice spacing so that no support set is degenerate
+static Reals jittered_lattice(LO n, unsigned seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<Real> jitter(-0.2 / n, 0.2 / n);
+  HostWrite<Real> points(2 * n * n, "jittered lattice");
+  for (LO i = 0; i < n; ++i) {
+    for (LO j = 0; j < n; ++j) {
+      points[2 * (i * n + j)] = (j + 0.5) / n + jitter(generator);
+      points[2 * (i * n + j) + 1] = (i + 0.5) / n + jitter(generator);
+    }
+  }
+  return Reals(points.write());
+}
+
+// points of an n x n lattice that includes the corners of the unit square
+static Reals target_lattice(LO n)
+{
+  HostWrite<Real> points(2 * n * n, "target lattice");
+  for (LO i = 0; i < n; ++i) {
+    for (LO j = 0; j < n; ++j) {
+      points[2 * (i * n + j)] = Real(j) / (n - 1);
+      points[2 * (i * n + j) + 1] = Real(i) / (n - 1);
+    }
+  }
+  return Reals(points.write());
+}
+
+// any quadratic is reproduced by the MLS interpolation with a quadratic basis
+static Real quadratic(Real x, Real y)
+{
+  return 1 + 2 * x + 3 * y + 4 * x * x + 5 * x * y + 6 * y * y;
+}
+
+static Reals sample_quadratic(const Reals& coords)
+{
+  HostRead<Real> coords_h(coords);
+  const LO npoints = coords.size() / 2;
+  HostWrite<Real> values(npoints, "quadratic values");
+  for (LO i = 0; i < npoints; ++i) {
+    values[i] = quadratic(coords_h[2 * i], coords_h[2 * i + 1]);
+  }
+  return Reals(values.write());
+}
+
+TEST_CASE("bin targets by support count")
+{
+  auto lib = Omega_h::Library{};
+  const std::vector<LO> counts{3, 16, 17, 40, 100, 5};
+  HostWrite<LO> supports_ptr(counts.size() + 1, "support offsets");
+  supports_ptr[0] = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    supports_ptr[i + 1] = supports_ptr[i] + counts[i];
+  }
+  SupportResults support;
+  support.supports_ptr = supports_ptr.write();
+
+  const auto bins = bin_by_support_count(support, counts.size());
+  const std::vector<LO> max_supports{16, 32, 64, 128};
+  REQUIRE(bins.max_supports == max_supports);
+  std::vector<int> nbins(counts.size(), 0);
+  for (size_t bin = 0; bin < bins.targets.size(); ++bin) {
+    HostRead<LO> targets(bins.targets[bin]);
+    for (LO j = 0; j < targets.size(); ++j) {
+      // the counts below the smallest bin size share the first bin
+      REQUIRE(counts[targets[j]] <= bins.max_supports[bin]);
+      REQUIRE((bin == 0 || counts[targets[j]] > bins.max_supports[bin] / 2));
+      ++nbins[targets[j]];
+    }
+  }
+  REQUIRE(nbins == std::vector<int>(counts.size(), 1));
+}
+
+TEST_CASE("binned MLS interpolation matches the unbinned interpolation")
+{
+  auto lib = Omega_h::Library{};
+  const auto source_coords = jittered_lattice(20, 42);
+  const auto target_coords = target_lattice(6);
+  const auto source_values = sample_quadratic(source_coords);
+  const LO ntargets = target_coords.size() / 2;
+
+  // corner, edge and interior targets have about 13, 25 and 50 supports, so
+  // they fall into different bins
+  const Real cutoff = 0.2 * 0.2;
+  GridSupportSearch search(source_coords);
+  auto support = search.radiusSearch(target_coords, cutoff);
+  REQUIRE(bin_by_support_count(support, ntargets).targets.size() == 3);
+
+  const auto binned = HostRead<Real>(
+    mls_interpolation(source_values, source_coords, target_coords, support, 2,
+                      support.radii2, RBFWu{}));
+  REQUIRE(binned.size() == ntargets);
+
+  // a single target is a single bin, sized for its own supports
+  HostRead<Real> target_coords_h(target_coords);
+  HostRead<LO> supports_ptr(support.supports_ptr);
+  HostRead<LO> supports_idx(support.supports_idx);
+  for (LO i = 0; i < ntargets; ++i) {
+    const LO nsupports = supports_ptr[i + 1] - supports_ptr[i];
+    HostWrite<Real> single_target(2, "single target");
+    single_target[0] = target_coords_h[2 * i];
+    single_target[1] = target_coords_h[2 * i + 1];
+    HostWrite<LO> single_ptr(2, "single target support offsets");
+    single_ptr[0] = 0;
+    single_ptr[1] = nsupports;
+    HostWrite<LO> single_idx(nsupports, "single target supports");
+    for (LO j = 0; j < nsupports; ++j) {
+      single_idx[j] = supports_idx[supports_ptr[i] + j];
+    }
+    SupportResults single_support;
+    single_support.supports_ptr = single_ptr.write();
+    single_support.supports_idx = single_idx.write();
+    single_support.radii2 = Write<Real>(1, cutoff, "single target radius");
+
+    const auto unbinned = HostRead<Real>(mls_interpolation(
+      source_values, source_coords, Reals(single_target.write()),
+      single_support, 2, single_support.radii2, RBFWu{}));
+    REQUIRE(binned[i] == Catch::Approx(unbinned[0]).margin(1e-10));
+    REQUIRE(binned[i] ==
+            Catch::Approx(quadratic(target_coords_h[2 * i],
+                                    target_coords_h[2 * i + 1]))
+              .margin(1e-8));
+  }
+}
+
+TEST_CASE("radial basis functions")
+{
+  const Real rho_sq = 1;
+  SECTION("center")
+  {
+    REQUIRE(RBFWu{}(0, rho_sq) == Catch::Approx(6));
+    REQUIRE(RBFWendlandC0{}(0, rho_sq) == Catch::Approx(1));
+    REQUIRE(RBFWendlandC2{}(0, rho_sq) == Catch::Approx(1));
+    REQUIRE(RBFWendlandC4{}(0, rho_sq) == Catch::Approx(3));
+    REQUIRE(RBFGaussian{}(0, rho_sq) == Catch::Approx(1 - std::exp(-4.0)));
+    REQUIRE(RBFInverseMultiquadric{}(0, rho_sq) ==
+            Catch::Approx(1 - 1 / std::sqrt(5.0)));
+  }
+  SECTION("half the cutoff")
+  {
+    const Real r_sq = 0.25;
+    REQUIRE(RBFWu{}(r_sq, rho_sq) == Catch::Approx(55.53125 / 64));
+    REQUIRE(RBFWendlandC0{}(r_sq, rho_sq) == Catch::Approx(0.25));
+    REQUIRE(RBFWendlandC2{}(r_sq, rho_sq) == Catch::Approx(0.1875));
+    REQUIRE(RBFWendlandC4{}(r_sq, rho_sq) == Catch::Approx(20.75 / 64));
+    REQUIRE(RBFGaussian{}(r_sq, rho_sq) ==
+            Catch::Approx(std::exp(-1.0) - std::exp(-4.0)));
+    REQUIRE(RBFInverseMultiquadric{}(r_sq, rho_sq) ==
+            Catch::Approx(1 / std::sqrt(2.0) - 1 / std::sqrt(5.0)));
+  }
+  SECTION("vanish at and beyond the cutoff")
+  {
+    for (const Real r_sq : {1.0, 2.0}) {
+      REQUIRE(RBFWu{}(r_sq, rho_sq) == 0);
+      REQUIRE(RBFWendlandC0{}(r_sq, rho_sq) == 0);
+      REQUIRE(RBFWendlandC2{}(r_sq, rho_sq) == 0);
+      REQUIRE(RBFWendlandC4{}(r_sq, rho_sq) == 0);
+      REQUIRE(RBFGaussian{}(r_sq, rho_sq) == 0);
+      REQUIRE(RBFInverseMultiquadric{}(r_sq, rho_sq) == 0);
+    }
+  }
+  SECTION("scale with the cutoff")
+  {
+    REQUIRE(RBFWendlandC2{}(1, 4) == Catch::Approx(0.1875));
+    REQUIRE(rbf(1, 4) == Catch::Approx(RBFWu{}(0.25, 1)));
+  }
+}
+
+TEST_CASE("MLS interpolation with each radial basis")
+{
+  auto lib = Omega_h::Library{};
+  const auto source_coords = jittered_lattice(20, 7);
+  const auto target_coords = target_lattice(6);
+  const auto source_values = sample_quadratic(source_coords);
+  const LO ntargets = target_coords.size() / 2;
+  GridSupportSearch search(source_coords);
+  auto support = search.radiusSearch(target_coords, 0.2 * 0.2);
+
+  HostRead<Real> target_coords_h(target_coords);
+  for (const auto basis :
+       {RadialBasis::WU, RadialBasis::WENDLAND_C0, RadialBasis::WENDLAND_C2,
+        RadialBasis::WENDLAND_C4, RadialBasis::GAUSSIAN,
+        RadialBasis::INVERSE_MULTIQUADRIC}) {
+    const auto values = HostRead<Real>(
+      mls_interpolation(source_values, source_coords, target_coords, support,
+                        2, support.radii2, basis));
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(values[i] == Catch::Approx(quadratic(target_coords_h[2 * i],
+                                                   target_coords_h[2 * i + 1]))
+                             .margin(1e-8));
+    }
+  }
+}
+
+TEST_CASE("MLS interpolation of several fields")
+{
+  auto lib = Omega_h::Library{};
+  const auto source_coords = jittered_lattice(20, 11);
+  const auto target_coords = target_lattice(6);
+  const LO nsources = source_coords.size() / 2;
+  const LO ntargets = target_coords.size() / 2;
+  GridSupportSearch search(source_coords);
+  auto support = search.radiusSearch(target_coords, 0.2 * 0.2);
+
+  // the second field is not a quadratic, so it is not reproduced exactly
+  HostRead<Real> source_coords_h(source_coords);
+  HostWrite<Real> first(nsources, "first field");
+  HostWrite<Real> second(nsources, "second field");
+  HostWrite<Real> fields(2 * nsources, "fields");
+  for (LO i = 0; i < nsources; ++i) {
+    Coord p{source_coords_h[2 * i], source_coords_h[2 * i + 1]};
+    first[i] = quadratic(p.x, p.y);
+    second[i] = func(p);
+    fields[i] = first[i];
+    fields[nsources + i] = second[i];
+  }
+
+  const auto values = HostRead<Real>(
+    mls_interpolation(Reals(fields.write()), source_coords, target_coords,
+                      support, 2, support.radii2, RBFWu{}));
+  const auto first_values = HostRead<Real>(
+    mls_interpolation(Reals(first.write()), source_coords, target_coords,
+                      support, 2, support.radii2, RBFWu{}));
+  const auto second_values = HostRead<Real>(
+    mls_interpolation(Reals(second.write()), source_coords, target_coords,
+                      support, 2, support.radii2, RBFWu{}));
+  // the fields are stored one after the other
+  REQUIRE(values.size() == 2 * ntargets);
+  for (LO i = 0; i < ntargets; ++i) {
+    REQUIRE(values[i] == Catch::Approx(first_values[i]).margin(1e-12));
+    REQUIRE(values[ntargets + i] ==
+            Catch::Approx(second_values[i]).margin(1e-12));
+  }
+}
+
+TEST_CASE("MLS derivatives of a quadratic")
+{
+  auto lib = Omega_h::Library{};
+  const auto source_coords = jittered_lattice(20, 13);
+  const auto target_coords = target_lattice(6);
+  const auto source_values = sample_quadratic(source_coords);
+  const LO ntargets = target_coords.size() / 2;
+  GridSupportSearch search(source_coords);
+  auto support = search.radiusSearch(target_coords, 0.2 * 0.2);
+  HostRead<Real> target_coords_h(target_coords);
+
+  // value, gradient and hessian of the quadratic
+  auto exact = [](Real x, Real y) {
+    return std::vector<Real>{quadratic(x, y), 2 + 8 * x + 5 * y,
+                             3 + 5 * x + 12 * y, 8, 5, 12};
+  };
+  for (const auto derivatives :
+       {MLSDerivatives::NONE, MLSDerivatives::GRADIENT,
+        MLSDerivatives::HESSIAN}) {
+    const int ncomponents = num_mls_components(derivatives);
+    const auto values = HostRead<Real>(
+      mls_interpolation(source_values, source_coords, target_coords, support,
+                        2, support.radii2, RBFWu{}, derivatives));
+    REQUIRE(values.size() == ncomponents * ntargets);
+    for (LO i = 0; i < ntargets; ++i) {
+      const auto expected =
+        exact(target_coords_h[2 * i], target_coords_h[2 * i + 1]);
+      for (int c = 0; c < ncomponents; ++c) {
+        REQUIRE(values[c * ntargets + i] ==
+                Catch::Approx(expected[c]).margin(1e-6));
+      }
+    }
+  }
+}
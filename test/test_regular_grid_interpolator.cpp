@@ -0,0 +1,409 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <bspline_interpolant.hpp>
+#include <random>
+#include <vector>
+
+static IntVecView make_int_view(const std::vector<int>& values)
+{
+  IntVecView view("int values", values.size());
+  auto view_h = Kokkos::create_mirror_view(view);
+  for (size_t i = 0; i < values.size(); ++i) {
+    view_h(i) = values[i];
+  }
+  Kokkos::deep_copy(view, view_h);
+  return view;
+}
+
+static RealVecView make_real_view(const std::vector<double>& values)
+{
+  RealVecView view("real values", values.size());
+  auto view_h = Kokkos::create_mirror_view(view);
+  for (size_t i = 0; i < values.size(); ++i) {
+    view_h(i) = values[i];
+  }
+  Kokkos::deep_copy(view, view_h);
+  return view;
+}
+
+// npoints random points with each coordinate in [lower, upper)
+static RealMatView random_points(int npoints, int dim, double lower,
+                                 double upper, unsigned seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(lower, upper);
+  RealMatView points("points", npoints, dim);
+  auto points_h = Kokkos::create_mirror_view(points);
+  for (int j = 0; j < npoints; ++j) {
+    for (int i = 0; i < dim; ++i) {
+      points_h(j, i) = distribution(generator);
+    }
+  }
+  Kokkos::deep_copy(points, points_h);
+  return points;
+}
+
+// values of f at the nodes of a uniform grid over the unit cube, stored row
+// major with the last dimension varying fastest
+template <typename F>
+static RealVecView sample_unit_grid(const std::vector<int>& num_bins, F f)
+{
+  const int dim = num_bins.size();
+  int size = 1;
+  for (const auto bins : num_bins) {
+    size *= bins + 1;
+  }
+  std::vector<double> values(size);
+  std::vector<double> coord(dim);
+  for (int index = 0; index < size; ++index) {
+    int remainder = index;
+    for (int i = dim - 1; i >= 0; --i) {
+      coord[i] = double(remainder % (num_bins[i] + 1)) / num_bins[i];
+      remainder /= num_bins[i] + 1;
+    }
+    values[index] = f(coord.data());
+  }
+  return make_real_view(values);
+}
+
+// multilinear functions are reproduced exactly by multilinear interpolation
+static double multilinear(const double* x)
+{
+  return 1 + x[0] + 2 * x[1] - x[2] + 0.5 * x[3] + 3 * x[0] * x[1] * x[2] * x[3];
+}
+
+TEST_CASE("compile time dimension regular grid interpolation")
+{
+  const std::vector<int> num_bins{3, 4, 2, 5};
+  const auto num_bins_view = make_int_view(num_bins);
+  const auto range = make_real_view({0, 1, 0, 1, 0, 1, 0, 1});
+  const auto values = sample_unit_grid(num_bins, multilinear);
+  const auto points = random_points(100, 4, 0, 1, 1);
+  const auto dimensions = grid_dimensions(num_bins_view);
+
+  auto result = parametric_indices(points, num_bins_view, range);
+  RegularGridInterpolator<4> interpolator(result.parametric_coords, values,
+                                          result.indices_pts, dimensions);
+  RegularGridInterpolator<> dynamic_interpolator(
+    result.parametric_coords, values, result.indices_pts, dimensions);
+  auto interpolated = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), interpolator.linear_interpolation());
+  auto dynamic_interpolated = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), dynamic_interpolator.linear_interpolation());
+
+  auto points_h = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), points);
+  for (int j = 0; j < points_h.extent_int(0); ++j) {
+    const double point[4] = {points_h(j, 0), points_h(j, 1), points_h(j, 2),
+                             points_h(j, 3)};
+    REQUIRE(interpolated(j) == Catch::Approx(dynamic_interpolated(j)));
+    REQUIRE(interpolated(j) == Catch::Approx(multilinear(point)));
+  }
+}
+
+TEST_CASE("fused locate and interpolate")
+{
+  const std::vector<int> num_bins{3, 4, 2, 5};
+  const auto num_bins_view = make_int_view(num_bins);
+  const auto range = make_real_view({0, 1, 0, 1, 0, 1, 0, 1});
+  const auto values = sample_unit_grid(num_bins, multilinear);
+  const auto points = random_points(100, 4, 0, 1, 2);
+
+  // two passes through the intermediate indices and parametric coordinates
+  auto two_pass = parametric_indices(points, num_bins_view, range);
+  RegularGridInterpolator<4> interpolator(
+    two_pass.parametric_coords, values, two_pass.indices_pts,
+    grid_dimensions(num_bins_view));
+  auto two_pass_values = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), interpolator.linear_interpolation());
+
+  SECTION("without intermediate")
+  {
+    auto fused_values = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(),
+      interpolate_regular_grid<4>(points, num_bins_view, range, values));
+    for (int j = 0; j < fused_values.extent_int(0); ++j) {
+      REQUIRE(fused_values(j) == Catch::Approx(two_pass_values(j)));
+    }
+  }
+  SECTION("with intermediate")
+  {
+    Result intermediate;
+    auto fused_values = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), interpolate_regular_grid<4>(
+                             points, num_bins_view, range, values, &intermediate));
+    auto indices = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), intermediate.indices_pts);
+    auto parametric_coords = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), intermediate.parametric_coords);
+    auto two_pass_indices = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), two_pass.indices_pts);
+    auto two_pass_parametric_coords = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), two_pass.parametric_coords);
+    REQUIRE(indices.extent(0) == two_pass_indices.extent(0));
+    REQUIRE(indices.extent(1) == 4);
+    for (int j = 0; j < fused_values.extent_int(0); ++j) {
+      REQUIRE(fused_values(j) == Catch::Approx(two_pass_values(j)));
+      for (int i = 0; i < 4; ++i) {
+        REQUIRE(indices(j, i) == two_pass_indices(j, i));
+        REQUIRE(parametric_coords(j, i) ==
+                Catch::Approx(two_pass_parametric_coords(j, i)).margin(1e-12));
+      }
+    }
+  }
+}
+
+// cubic in each coordinate, so the cubic B-spline reproduces it away from
+// the mirror boundary conditions
+static double cubic(const double* x)
+{
+  return x[0] * x[0] * x[0] - 0.5 * x[0] + x[1] * x[1] * x[1] +
+         x[0] * x[1] * x[1];
+}
+
+TEST_CASE("cubic B-spline interpolation")
+{
+  const std::vector<int> num_bins{64, 64};
+  const auto num_bins_view = make_int_view(num_bins);
+  const auto range = make_real_view({0, 1, 0, 1});
+  const auto values = sample_unit_grid(num_bins, cubic);
+  BSplineGridInterpolator<2> interpolator(num_bins_view, range, values);
+  SECTION("interpolates the nodes")
+  {
+    const int n = num_bins[0] + 1;
+    RealMatView nodes("nodes", n * n, 2);
+    auto nodes_h = Kokkos::create_mirror_view(nodes);
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j < n; ++j) {
+        nodes_h(i * n + j, 0) = double(i) / num_bins[0];
+        nodes_h(i * n + j, 1) = double(j) / num_bins[1];
+      }
+    }
+    Kokkos::deep_copy(nodes, nodes_h);
+    auto interpolated = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), interpolator.interpolate(nodes));
+    auto values_h =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), values);
+    for (int k = 0; k < n * n; ++k) {
+      REQUIRE(interpolated(k) == Catch::Approx(values_h(k)).margin(1e-10));
+    }
+  }
+  SECTION("reproduces a cubic in the interior")
+  {
+    const auto points = random_points(200, 2, 0.25, 0.75, 3);
+    auto interpolated = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), interpolator.interpolate(points));
+    auto linear = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(),
+      interpolate_regular_grid<2>(points, num_bins_view, range, values));
+    auto points_h =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), points);
+    double max_bspline_error = 0;
+    double max_linear_error = 0;
+    for (int j = 0; j < points_h.extent_int(0); ++j) {
+      const double point[2] = {points_h(j, 0), points_h(j, 1)};
+      const double exact = cubic(point);
+      max_bspline_error =
+        std::max(max_bspline_error, std::abs(interpolated(j) - exact));
+      max_linear_error =
+        std::max(max_linear_error, std::abs(linear(j) - exact));
+    }
+    REQUIRE(max_bspline_error < 1e-8);
+    REQUIRE(max_bspline_error < 1e-3 * max_linear_error);
+  }
+}
+
+TEST_CASE("find cell of sorted node coordinates")
+{
+  const double coords[5] = {0, 1, 2, 3, 4};
+  SECTION("inside")
+  {
+    REQUIRE(find_cell(coords, 5, 0.5) == 0);
+    REQUIRE(find_cell(coords, 5, 2.5) == 2);
+    REQUIRE(find_cell(coords, 5, 3.99) == 3);
+  }
+  SECTION("nodes start their cell")
+  {
+    REQUIRE(find_cell(coords, 5, 0) == 0);
+    REQUIRE(find_cell(coords, 5, 1) == 1);
+    REQUIRE(find_cell(coords, 5, 3) == 3);
+  }
+  SECTION("edges of the grid")
+  {
+    // the last node and the points outside fall into the boundary cells
+    REQUIRE(find_cell(coords, 5, 4) == 3);
+    REQUIRE(find_cell(coords, 5, 10) == 3);
+    REQUIRE(find_cell(coords, 5, -1) == 0);
+    REQUIRE(find_cell(coords, 2, 0.5) == 0);
+    REQUIRE(find_cell(coords, 2, 7) == 0);
+  }
+}
+
+TEST_CASE("rectilinear grid interpolation")
+{
+  auto bilinear = [](double x, double y) { return 1 + 2 * x - y + 3 * x * y; };
+  SECTION("stretched grid")
+  {
+    const std::vector<double> x{0, 0.1, 0.3, 0.7, 1.5};
+    const std::vector<double> y{-1, 0, 2};
+    std::vector<double> grid_coords(x);
+    grid_coords.insert(grid_coords.end(), y.begin(), y.end());
+    std::vector<double> values;
+    for (const auto xi : x) {
+      for (const auto yi : y) {
+        values.push_back(bilinear(xi, yi));
+      }
+    }
+    RealMatView points("points", 100, 2);
+    auto points_h = Kokkos::create_mirror_view(points);
+    std::mt19937 generator(4);
+    std::uniform_real_distribution<double> x_distribution(0, 1.5);
+    std::uniform_real_distribution<double> y_distribution(-1, 2);
+    for (int j = 0; j < 100; ++j) {
+      points_h(j, 0) = x_distribution(generator);
+      points_h(j, 1) = y_distribution(generator);
+    }
+    Kokkos::deep_copy(points, points_h);
+    auto interpolated = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(),
+      interpolate_rectilinear_grid<2>(points, make_int_view({5, 3}),
+                                      make_real_view(grid_coords),
+                                      make_real_view(values)));
+    for (int j = 0; j < 100; ++j) {
+      REQUIRE(interpolated(j) ==
+              Catch::Approx(bilinear(points_h(j, 0), points_h(j, 1))));
+    }
+  }
+  SECTION("single node dimension")
+  {
+    // the values only vary along x, and no point reads past the 4 values
+    const std::vector<double> x{0, 1, 2, 4};
+    std::vector<double> grid_coords(x);
+    grid_coords.push_back(0.5);
+    std::vector<double> values;
+    for (const auto xi : x) {
+      values.push_back(bilinear(xi, 0.5));
+    }
+    RealMatView points("points", 3, 2);
+    auto points_h = Kokkos::create_mirror_view(points);
+    const double xs[3] = {0.5, 3, 4};
+    const double ys[3] = {0.5, -2, 7};
+    for (int j = 0; j < 3; ++j) {
+      points_h(j, 0) = xs[j];
+      points_h(j, 1) = ys[j];
+    }
+    Kokkos::deep_copy(points, points_h);
+    auto interpolated = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(),
+      interpolate_rectilinear_grid<2>(points, make_int_view({4, 1}),
+                                      make_real_view(grid_coords),
+                                      make_real_view(values)));
+    for (int j = 0; j < 3; ++j) {
+      REQUIRE(interpolated(j) == Catch::Approx(bilinear(xs[j], 0.5)));
+    }
+  }
+}
+
+TEST_CASE("batched regular grid interpolation")
+{
+  const std::vector<int> num_bins{6, 5};
+  const auto num_bins_view = make_int_view(num_bins);
+  const auto range = make_real_view({0, 1, 0, 1});
+  const auto points = random_points(50, 2, 0, 1, 5);
+  auto result = parametric_indices(points, num_bins_view, range);
+  RegularGridInterpolator<2> interpolator(result.parametric_coords,
+                                          RealVecView{}, result.indices_pts,
+                                          grid_dimensions(num_bins_view));
+
+  const int grid_size = (num_bins[0] + 1) * (num_bins[1] + 1);
+  // a quantity count that does not fill the vector lanes
+  for (const int K : {1, 3, 5}) {
+    std::mt19937 generator(K);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    RealMatView batched_values("batched values", grid_size, K);
+    auto batched_values_h = Kokkos::create_mirror_view(batched_values);
+    for (int node = 0; node < grid_size; ++node) {
+      for (int k = 0; k < K; ++k) {
+        batched_values_h(node, k) = distribution(generator);
+      }
+    }
+    Kokkos::deep_copy(batched_values, batched_values_h);
+    auto batched = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), interpolator.linear_interpolation(batched_values));
+    REQUIRE(batched.extent_int(0) == 50);
+    REQUIRE(batched.extent_int(1) == K);
+
+    // each quantity on its own
+    for (int k = 0; k < K; ++k) {
+      RealVecView values("values", grid_size);
+      Kokkos::deep_copy(values,
+                        Kokkos::subview(batched_values, Kokkos::ALL(), k));
+      RegularGridInterpolator<2> single(result.parametric_coords, values,
+                                        result.indices_pts,
+                                        grid_dimensions(num_bins_view));
+      auto interpolated = Kokkos::create_mirror_view_and_copy(
+        Kokkos::HostSpace(), single.linear_interpolation());
+      for (int j = 0; j < 50; ++j) {
+        REQUIRE(batched(j, k) == Catch::Approx(interpolated(j)).margin(1e-12));
+      }
+    }
+  }
+}
+
+TEST_CASE("out of bounds policies")
+{
+  // f(x) = 2x + 1 on 4 cells over [0, 1], with a point on the upper
+  // boundary and a point outside of each end of the grid
+  const auto num_bins = make_int_view({4});
+  const auto range = make_real_view({0, 1});
+  const auto grid_coords = make_real_view({0, 0.25, 0.5, 0.75, 1});
+  const auto values = make_real_view({1, 1.5, 2, 2.5, 3});
+  const std::vector<double> xs{-0.5, 0, 0.3, 1, 1.5};
+  RealMatView points("points", xs.size(), 1);
+  auto points_h = Kokkos::create_mirror_view(points);
+  for (size_t j = 0; j < xs.size(); ++j) {
+    points_h(j, 0) = xs[j];
+  }
+  Kokkos::deep_copy(points, points_h);
+  const double fill_value = -7;
+
+  auto check = [&](const RealVecView& interpolated,
+                   const std::vector<double>& expected) {
+    auto interpolated_h =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), interpolated);
+    REQUIRE(interpolated_h.extent(0) == expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      REQUIRE(interpolated_h(j) == Catch::Approx(expected[j]).margin(1e-12));
+    }
+  };
+  SECTION("extrapolate")
+  {
+    const std::vector<double> expected{0, 1, 1.6, 3, 4};
+    check(interpolate_regular_grid<1, OutOfBounds::EXTRAPOLATE>(
+            points, num_bins, range, values),
+          expected);
+    check(interpolate_rectilinear_grid<1, OutOfBounds::EXTRAPOLATE>(
+            points, grid_dimensions(num_bins), grid_coords, values),
+          expected);
+  }
+  SECTION("clamp")
+  {
+    const std::vector<double> expected{1, 1, 1.6, 3, 3};
+    check(interpolate_regular_grid<1, OutOfBounds::CLAMP>(points, num_bins,
+                                                          range, values),
+          expected);
+    check(interpolate_rectilinear_grid<1, OutOfBounds::CLAMP>(
+            points, grid_dimensions(num_bins), grid_coords, values),
+          expected);
+  }
+  SECTION("fill")
+  {
+    const std::vector<double> expected{fill_value, 1, 1.6, 3, fill_value};
+    check(interpolate_regular_grid<1, OutOfBounds::FILL>(
+            points, num_bins, range, values, nullptr, fill_value),
+          expected);
+    check(interpolate_rectilinear_grid<1, OutOfBounds::FILL>(
+            points, grid_dimensions(num_bins), grid_coords, values,
+            fill_value),
+          expected);
+  }
+}
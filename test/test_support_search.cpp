@@ -0,0 +1,386 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <grid_search.hpp>
+#include <Omega_h_build.hpp>
+#include <Omega_h_library.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// random points in the square [lower, upper]^2
+static Reals random_points(LO npoints, Real lower, Real upper, unsigned seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<Real> distribution(lower, upper);
+  HostWrite<Real> points(2 * npoints, "random points");
+  for (LO i = 0; i < 2 * npoints; ++i) {
+    points[i] = distribution(generator);
+  }
+  return Reals(points.write());
+}
+
+// source points within the squared radius of the target, found by checking
+// every source point
+static std::vector<LO> brute_force_supports(const HostRead<Real>& sources,
+                                            const Real* target, Real radius2)
+{
+  std::vector<LO> supports;
+  for (LO j = 0; j < sources.size() / 2; ++j) {
+    const Real dx = sources[2 * j] - target[0];
+    const Real dy = sources[2 * j + 1] - target[1];
+    if (dx * dx + dy * dy <= radius2) {
+      supports.push_back(j);
+    }
+  }
+  return supports;
+}
+
+// sorted supports of target k of a CSR support list
+static std::vector<LO> sorted_supports(const HostRead<LO>& supports_ptr,
+                                       const HostRead<LO>& supports_idx, LO k)
+{
+  std::vector<LO> supports(supports_idx.data() + supports_ptr[k],
+                           supports_idx.data() + supports_ptr[k + 1]);
+  std::sort(supports.begin(), supports.end());
+  return supports;
+}
+
+TEST_CASE("BFS queue overflow")
+{
+  queue<4> q;
+  REQUIRE(q.isEmpty());
+  for (LO i = 0; i < 4; ++i) {
+    q.push_back(i);
+  }
+  REQUIRE(q.isFull());
+  REQUIRE_FALSE(q.overflowed());
+  // a push past the capacity is dropped rather than overwriting queued ids
+  q.push_back(4);
+  REQUIRE(q.overflowed());
+  for (LO i = 0; i < 4; ++i) {
+    REQUIRE(q.front() == i);
+    q.pop_front();
+  }
+  REQUIRE(q.isEmpty());
+}
+
+TEST_CASE("BFS visited set")
+{
+  track<8> visited;
+  SECTION("insert reports new ids")
+  {
+    REQUIRE(visited.insert(3));
+    REQUIRE(visited.insert(11));
+    REQUIRE_FALSE(visited.insert(3));
+    REQUIRE_FALSE(visited.insert(11));
+    REQUIRE(visited.size() == 2);
+    REQUIRE_FALSE(visited.overflowed());
+  }
+  SECTION("overflow past half the capacity")
+  {
+    for (LO i = 0; i < 4; ++i) {
+      REQUIRE(visited.insert(i * 8));
+    }
+    REQUIRE_FALSE(visited.overflowed());
+    // ids visited before are still found once the set is full
+    REQUIRE_FALSE(visited.insert(16));
+    REQUIRE_FALSE(visited.overflowed());
+    REQUIRE_FALSE(visited.insert(5));
+    REQUIRE(visited.overflowed());
+    REQUIRE(visited.size() == 4);
+  }
+}
+
+TEST_CASE("BFS capacity estimate")
+{
+  const Real area = 0.01;
+  for (const int capacity :
+       {bfs_capacity_small, bfs_capacity_medium, bfs_capacity_large}) {
+    const auto radius_sq = max_bfs_radius_sq(capacity, area);
+    REQUIRE(radius_sq > 0);
+    REQUIRE(estimate_bfs_capacity(radius_sq, area) <= capacity + 1);
+  }
+  REQUIRE(max_bfs_radius_sq(4, area) == 0);
+}
+
+TEST_CASE("single pass adjacency support search")
+{
+  auto lib = Omega_h::Library{};
+  auto mesh =
+    Omega_h::build_box(lib.world(), OMEGA_H_SIMPLEX, 1, 1, 1, 20, 20, 0, false);
+  const LO nverts = mesh.nverts();
+  HostRead<Real> coords(mesh.coords());
+  FindSupports search(mesh, SupportSource::VERTEX);
+
+  const Real radius2 = 0.12 * 0.12;
+  Write<Real> radii2(nverts, radius2, "squared radii");
+  SECTION("all targets")
+  {
+    Write<LO> candidates_ptr;
+    Write<LO> candidates;
+    search.adjBasedSearch(LOs(nverts, 0, 1, "all targets"), radii2,
+                          candidates_ptr, candidates);
+    HostRead<LO> ptr(candidates_ptr);
+    HostRead<LO> idx(candidates);
+    REQUIRE(ptr.size() == nverts + 1);
+    REQUIRE(ptr[nverts] == idx.size());
+    for (LO i = 0; i < nverts; ++i) {
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              brute_force_supports(coords, coords.data() + 2 * i, radius2));
+    }
+  }
+  SECTION("listed targets")
+  {
+    // every third vertex, with the supports stored in the order of the list
+    const LO ntargets = (nverts + 2) / 3;
+    Write<LO> candidates_ptr;
+    Write<LO> candidates;
+    search.adjBasedSearch(LOs(ntargets, 0, 3, "listed targets"), radii2,
+                          candidates_ptr, candidates);
+    HostRead<LO> ptr(candidates_ptr);
+    HostRead<LO> idx(candidates);
+    REQUIRE(ptr.size() == ntargets + 1);
+    for (LO k = 0; k < ntargets; ++k) {
+      REQUIRE(sorted_supports(ptr, idx, k) ==
+              brute_force_supports(coords, coords.data() + 2 * 3 * k, radius2));
+    }
+  }
+}
+
+TEST_CASE("support radius growth over a worklist")
+{
+  auto lib = Omega_h::Library{};
+  auto world = lib.world();
+  auto mesh =
+    Omega_h::build_box(world, OMEGA_H_SIMPLEX, 1, 1, 1, 20, 20, 0, false);
+  const LO nverts = mesh.nverts();
+  HostRead<Real> coords(mesh.coords());
+  SECTION("deficient targets grow their radius")
+  {
+    // the interior vertices have 5 supports within the cutoff, the boundary
+    // vertices fewer
+    FindSupports search(mesh, SupportSource::VERTEX);
+    const Real cutoff = 0.06 * 0.06;
+    const LO min_support = 5;
+    auto support = searchNeighbors(search, cutoff, min_support);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    LO ngrown = 0;
+    for (LO i = 0; i < nverts; ++i) {
+      const auto supports = sorted_supports(ptr, idx, i);
+      REQUIRE(static_cast<LO>(supports.size()) >= min_support);
+      // the supports of the retried targets are merged back in place
+      REQUIRE(supports ==
+              brute_force_supports(coords, coords.data() + 2 * i, radii2[i]));
+      const auto initial =
+        brute_force_supports(coords, coords.data() + 2 * i, cutoff);
+      if (static_cast<LO>(initial.size()) >= min_support) {
+        REQUIRE(radii2[i] == cutoff);
+      } else {
+        REQUIRE(radii2[i] > cutoff);
+        ++ngrown;
+      }
+    }
+    REQUIRE(ngrown == 4 * 20);
+  }
+  SECTION("saturated targets stop growing")
+  {
+    // more supports than there are sources can never be found, so the radii
+    // grow until they reach the largest radius the BFS can search
+    FindSupports search(mesh, SupportSource::VERTEX);
+    const Real max_radius2 = search.maxRadius2();
+    REQUIRE(max_radius2 > 0);
+    REQUIRE(max_radius2 <= 2);
+    auto support = searchNeighbors(search, 0.1 * 0.1, 2 * nverts,
+                                   std::numeric_limits<LO>::max(), 20);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    for (LO i = 0; i < nverts; ++i) {
+      REQUIRE(radii2[i] == max_radius2);
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              brute_force_supports(coords, coords.data() + 2 * i,
+                                   max_radius2));
+    }
+  }
+  SECTION("targets outside of the source mesh are not retried")
+  {
+    auto target_mesh =
+      Omega_h::build_box(world, OMEGA_H_SIMPLEX, 2, 2, 1, 10, 10, 0, false);
+    const LO ntargets = target_mesh.nverts();
+    FindSupports search(mesh, target_mesh, SupportSource::VERTEX);
+    const Real cutoff = 0.06 * 0.06;
+    auto support = searchNeighbors(search, cutoff, 5);
+    HostRead<LO> seed_ptr(search.seedOffsets());
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<Real> radii2(support.radii2);
+    HostRead<Real> target_coords(target_mesh.coords());
+    for (LO i = 0; i < ntargets; ++i) {
+      const bool outside =
+        target_coords[2 * i] > 1.1 || target_coords[2 * i + 1] > 1.1;
+      if (outside) {
+        REQUIRE(seed_ptr[i + 1] == seed_ptr[i]);
+      }
+      if (seed_ptr[i + 1] == seed_ptr[i]) {
+        REQUIRE(ptr[i + 1] == ptr[i]);
+        REQUIRE(radii2[i] == cutoff);
+      } else {
+        REQUIRE(ptr[i + 1] - ptr[i] >= 5);
+      }
+    }
+  }
+}
+
+TEST_CASE("grid support search")
+{
+  auto lib = Omega_h::Library{};
+  const auto sources = random_points(500, 0, 1, 3);
+  // some targets are outside of the grid of the sources
+  const auto targets = random_points(50, -0.1, 1.1, 5);
+  const LO ntargets = targets.size() / 2;
+  HostRead<Real> sources_h(sources);
+  HostRead<Real> targets_h(targets);
+  GridSupportSearch search(sources);
+  SECTION("radius search")
+  {
+    const Real cutoff = 0.1 * 0.1;
+    auto support = search.radiusSearch(targets, cutoff);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              brute_force_supports(sources_h, targets_h.data() + 2 * i,
+                                   cutoff));
+      REQUIRE(radii2[i] == cutoff);
+    }
+  }
+  SECTION("kNN search")
+  {
+    const LO k = 8;
+    auto support = search.knnSearch(targets, k);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    for (LO i = 0; i < ntargets; ++i) {
+      std::vector<Real> distances;
+      for (LO j = 0; j < sources_h.size() / 2; ++j) {
+        const Real dx = sources_h[2 * j] - targets_h[2 * i];
+        const Real dy = sources_h[2 * j + 1] - targets_h[2 * i + 1];
+        distances.push_back(dx * dx + dy * dy);
+      }
+      const auto supports = sorted_supports(ptr, idx, i);
+      REQUIRE(static_cast<LO>(supports.size()) == k);
+      REQUIRE(std::adjacent_find(supports.begin(), supports.end()) ==
+              supports.end());
+      Real farthest = 0;
+      for (const auto source : supports) {
+        farthest = std::max(farthest, distances[source]);
+      }
+      std::nth_element(distances.begin(), distances.begin() + k - 1,
+                       distances.end());
+      REQUIRE(farthest == distances[k - 1]);
+      REQUIRE(radii2[i] == Catch::Approx(1.1 * farthest));
+    }
+  }
+  SECTION("fewer sources than neighbors")
+  {
+    GridSupportSearch small_search(random_points(5, 0, 1, 9));
+    auto support = small_search.knnSearch(targets, 8);
+    HostRead<LO> ptr(support.supports_ptr);
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(ptr[i + 1] - ptr[i] == 5);
+    }
+  }
+  SECTION("targets on the sources have a nonzero radius")
+  {
+    auto support = search.knnSearch(sources, 1);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    for (LO i = 0; i < idx.size(); ++i) {
+      REQUIRE(idx[i] == i);
+      REQUIRE(radii2[i] > 0);
+    }
+  }
+}
+
+TEST_CASE("support search across meshes")
+{
+  auto lib = Omega_h::Library{};
+  auto world = lib.world();
+  auto source_mesh =
+    Omega_h::build_box(world, OMEGA_H_SIMPLEX, 1, 1, 1, 20, 20, 0, false);
+  auto target_mesh =
+    Omega_h::build_box(world, OMEGA_H_SIMPLEX, 1, 1, 1, 7, 7, 0, false);
+  const LO ntargets = target_mesh.nverts();
+  HostRead<Real> source_coords(source_mesh.coords());
+  HostRead<Real> target_coords(target_mesh.coords());
+  Real cutoff = 0.12 * 0.12;
+  SECTION("fixed cutoff by default")
+  {
+    auto support = searchNeighbors(source_mesh, target_mesh, cutoff);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<Real> radii2(support.radii2);
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(radii2[i] == cutoff);
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              brute_force_supports(source_coords, target_coords.data() + 2 * i,
+                                   cutoff));
+    }
+  }
+  SECTION("cached point search")
+  {
+    pcms::GridPointSearch point_search(source_mesh, 10, 10);
+    FindSupports search(source_mesh, target_mesh, point_search);
+    auto support = searchNeighbors(search, cutoff, 0);
+    FindSupports uncached_search(source_mesh, target_mesh);
+    auto uncached = searchNeighbors(uncached_search, cutoff, 0);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    HostRead<LO> uncached_ptr(uncached.supports_ptr);
+    HostRead<LO> uncached_idx(uncached.supports_idx);
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              sorted_supports(uncached_ptr, uncached_idx, i));
+    }
+  }
+  SECTION("radius growth is opt in")
+  {
+    Real small_cutoff = 0.03 * 0.03;
+    auto support = searchNeighbors(source_mesh, target_mesh, small_cutoff, 8);
+    HostRead<LO> ptr(support.supports_ptr);
+    for (LO i = 0; i < ntargets; ++i) {
+      REQUIRE(ptr[i + 1] - ptr[i] >= 8);
+    }
+  }
+  SECTION("cell centroid sources")
+  {
+    const auto nfaces = source_mesh.nfaces();
+    HostRead<LO> faces2verts(
+      source_mesh.ask_down(Omega_h::FACE, Omega_h::VERT).ab2b);
+    HostWrite<Real> centroids(2 * nfaces, "cell centroids");
+    for (LO f = 0; f < nfaces; ++f) {
+      for (int d = 0; d < 2; ++d) {
+        Real sum = 0;
+        for (int v = 0; v < 3; ++v) {
+          sum += source_coords[2 * faces2verts[3 * f + v] + d];
+        }
+        centroids[2 * f + d] = sum / 3;
+      }
+    }
+    HostRead<Real> centroids_h(Reals(centroids.write()));
+
+    // the targets are the vertices of the source mesh itself
+    FindSupports search(source_mesh);
+    auto support = searchNeighbors(search, cutoff, 0);
+    HostRead<LO> ptr(support.supports_ptr);
+    HostRead<LO> idx(support.supports_idx);
+    for (LO i = 0; i < source_mesh.nverts(); ++i) {
+      REQUIRE(sorted_supports(ptr, idx, i) ==
+              brute_force_supports(centroids_h, source_coords.data() + 2 * i,
+                                   cutoff));
+    }
+  }
+}